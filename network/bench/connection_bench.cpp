@@ -0,0 +1,629 @@
+/**
+ * @author lafftale1999
+ *
+ * @brief Loopback benchmarks of lynks::network::connection. A minimal server accepts connections on
+ * an ephemeral port and answers every request with the pre-serialized `200` of `/health`, so what is
+ * measured is the connection itself: reading, timeouts and writing.
+ *
+ * Usage:
+ *   bench_connection soak [clients per kind] [seconds]
+ *     Opens idle, slow-header and slow-body clients in rounds next to well-behaved ones, with one
+ *     second read timeouts. Checks that every stalled client is closed by the timeout of its phase,
+ *     that the timeout counters match and that no connection or file descriptor is left behind.
+ *
+ *   bench_connection throughput [requests] [--tls certificate.pem key.pem]
+ *     Times new connections, sequential keep-alive requests and pipelined requests over plaintext,
+ *     and with `--tls` over TLS with full and with resumed handshakes.
+ *
+ *   bench_connection allocations [requests]
+ *     Counts the heap allocations of the server thread per keep-alive request, for replies sent
+ *     inline like the routes that need no I/O, and for replies sent from a coroutine spawned per
+ *     request like the routes that do.
+ *
+ *   bench_connection workers [clients] [seconds]
+ *     Keep-alive throughput of a context run by 1, 2, 4 and 8 worker threads, with every connection
+ *     on a strand of its own, like the shared context of the server.
+ */
+
+#include "network_connection.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <new>
+#include <optional>
+#include <set>
+#include <string>
+
+#include <boost/asio/ssl.hpp>
+
+using namespace lynks::network;
+using clock_type = std::chrono::steady_clock;
+
+/*
+--------------------------- ALLOCATION COUNTER --------------------------------------
+*/
+
+// GCC sees the malloc in operator new and the free in operator delete through inlining and takes them
+// for a mismatched pair
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+static thread_local bool count_allocations = false;     /**< Set on the thread of the server only */
+static std::atomic<uint64_t> allocations{0};
+
+void* operator new(std::size_t size) {
+    if (count_allocations) allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+/**
+ * @brief How the server answers a request.
+ */
+enum class reply_mode {
+    immediate,      /**< From the request hook, like the routes served by `router::try_handle_now()` */
+    spawned         /**< From a coroutine spawned on the executor of the client, like every other route */
+};
+
+/**
+ * @brief Connections served on a loopback acceptor by `threads` threads running one context. With
+ * more than one thread every connection gets a strand of its own, like the shared context of the
+ * server.
+ */
+class bench_server {
+    public:
+        explicit bench_server(connection_options options, tls_context* tls = nullptr, reply_mode mode = reply_mode::immediate,
+            std::size_t threads = 1)
+        : context(static_cast<int>(threads)), cache(std::chrono::seconds(1)), options(options), tls(tls), mode(mode), strands(threads > 1),
+          acceptor(context, { asio::ip::make_address("127.0.0.1"), 0 })
+        {
+            accept();
+
+            for (std::size_t i = 0; i < std::max<std::size_t>(threads, 1); i++) {
+                workers.emplace_back([this](){
+                    count_allocations = true;
+                    context.run();
+                });
+            }
+        }
+
+        ~bench_server() {
+            context.stop();
+            for (auto& worker : workers) worker.join();
+        }
+
+        uint16_t port() const { return acceptor.local_endpoint().port(); }
+
+        /**
+         * @brief Connections accepted and not yet closed.
+         */
+        std::size_t open() const { return open_connections.load(); }
+
+        const connection_counters& get_counters() const { return counters; }
+
+    private:
+        void accept() {
+            // a context run by one thread needs no strand
+            asio::any_io_executor executor = context.get_executor();
+            if (strands) executor = asio::make_strand(context);
+
+            acceptor.async_accept(executor, [this](std::error_code ec, asio::ip::tcp::socket socket){
+                if (ec) return;
+
+                open_connections++;
+
+                auto client = std::make_shared<connection>(std::move(socket), connection_hooks{
+                    [this](std::shared_ptr<connection> client, message_handle<server_request>& request){
+                        if (mode == reply_mode::immediate) {
+                            client->send_serialized(request.sequence, cache.health().get(request.data.keep_alive()));
+                            return;
+                        }
+
+                        spawn_reply(std::move(client), request.sequence, request.data.keep_alive());
+                    },
+                    {},
+                    [this](std::shared_ptr<connection> client){
+                        std::scoped_lock<std::mutex> lock(mtx);
+                        live.erase(client);
+                        open_connections--;
+                    }
+                }, counters, cache, options, tls);
+
+                {
+                    std::scoped_lock<std::mutex> lock(mtx);
+                    live.insert(client);
+                }
+
+                client->connect_to_client(1);
+                accept();
+            });
+        }
+
+        /**
+         * @brief Answers through two nested awaitables, the spawned handler and the route it awaits.
+         */
+        void spawn_reply(std::shared_ptr<connection> client, uint32_t sequence, bool keep_alive) {
+            auto executor = client->get_executor();
+            auto slot = client->request_slot(sequence);
+
+            asio::co_spawn(
+                executor,
+                [this, client, sequence, keep_alive]() -> asio::awaitable<void> {
+                    auto reply = co_await route(keep_alive);
+                    client->send_serialized(sequence, std::move(reply));
+                },
+                asio::bind_cancellation_slot(slot, [client, sequence](std::exception_ptr){
+                    client->request_slot(sequence).clear();
+                })
+            );
+        }
+
+        asio::awaitable<serialized_response> route(bool keep_alive) {
+            co_return cache.health().get(keep_alive);
+        }
+
+    private:
+        asio::io_context context;
+        connection_counters counters;
+        response_cache cache;
+        connection_options options;
+        tls_context* tls;
+        reply_mode mode;
+        bool strands;
+        asio::ip::tcp::acceptor acceptor;
+        std::vector<std::thread> workers;
+
+        std::mutex mtx;
+        std::set<std::shared_ptr<connection>> live;     /**< Owned here like the registry of the server does */
+        std::atomic<std::size_t> open_connections{0};
+};
+
+static std::size_t open_descriptors() {
+    std::size_t count = 0;
+    for ([[maybe_unused]] const auto& entry : std::filesystem::directory_iterator("/proc/self/fd")) count++;
+
+    return count;
+}
+
+/*
+--------------------------- SOAK --------------------------------------
+*/
+
+/**
+ * @brief What a soak client sends before it stalls.
+ */
+enum class client_kind { idle, slow_header, slow_body, well_behaved };
+
+static constexpr std::string_view REQUEST = "GET /health HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+static std::string_view prefix_of(client_kind kind) {
+    switch (kind) {
+        case client_kind::idle:         return "";
+        case client_kind::slow_header:  return "GET /health HTTP/1.1\r\nHost: local";
+        case client_kind::slow_body:    return "POST /login HTTP/1.1\r\nHost: localhost\r\nContent-Length: 64\r\n\r\n{\"user";
+        case client_kind::well_behaved: return REQUEST;
+    }
+
+    return "";
+}
+
+/**
+ * @brief Sends the prefix of `kind` and reads until the server closes the connection.
+ *
+ * @param closed_after time from connecting until the close was seen.
+ */
+static asio::awaitable<void> soak_client(uint16_t port, client_kind kind, clock_type::duration& closed_after, bool& answered) {
+    auto executor = co_await asio::this_coro::executor;
+    asio::ip::tcp::socket socket(executor);
+
+    co_await socket.async_connect({ asio::ip::make_address("127.0.0.1"), port }, asio::use_awaitable);
+    auto connected = clock_type::now();
+
+    auto prefix = prefix_of(kind);
+    if (!prefix.empty()) co_await asio::async_write(socket, asio::buffer(prefix), asio::use_awaitable);
+
+    char buffer[1024];
+    boost::system::error_code ec;
+
+    while (!ec) {
+        auto read = co_await socket.async_read_some(asio::buffer(buffer), asio::redirect_error(asio::use_awaitable, ec));
+        if (read > 0) answered = true;
+
+        // a well-behaved client leaves once it has its answer
+        if (kind == client_kind::well_behaved && answered) break;
+    }
+
+    closed_after = clock_type::now() - connected;
+}
+
+/**
+ * @brief Runs rounds of stalled and well-behaved clients until `seconds` have passed.
+ *
+ * @return `true` if every check held.
+ */
+static bool soak(std::size_t clients, std::chrono::seconds seconds) {
+    connection_options options;
+    options.idle_timeout = std::chrono::seconds(1);
+    options.header_timeout = std::chrono::seconds(1);
+    options.body_timeout = std::chrono::seconds(1);
+    options.write_timeout = std::chrono::seconds(1);
+
+    auto descriptors_before = open_descriptors();
+    bool passed = true;
+
+    {
+        bench_server server(options);
+        auto ends = clock_type::now() + seconds;
+
+        const client_kind kinds[] = { client_kind::idle, client_kind::slow_header, client_kind::slow_body, client_kind::well_behaved };
+        const char* names[] = { "idle", "slow header", "slow body", "well behaved" };
+        std::size_t stalled = 0;
+
+        for (std::size_t round = 1; clock_type::now() < ends; round++) {
+            asio::io_context client_context;
+
+            std::vector<clock_type::duration> closed_after(clients * std::size(kinds));
+            std::vector<char> answered(closed_after.size(), 0);
+
+            for (std::size_t k = 0; k < std::size(kinds); k++) {
+                for (std::size_t c = 0; c < clients; c++) {
+                    auto i = k * clients + c;
+                    asio::co_spawn(client_context, [&, i, kind = kinds[k]]() -> asio::awaitable<void> {
+                        bool got = false;
+                        co_await soak_client(server.port(), kind, closed_after[i], got);
+                        answered[i] = got;
+                    }, asio::detached);
+                }
+            }
+
+            client_context.run();
+            stalled += 3 * clients;
+
+            std::printf("round %zu:", round);
+            for (std::size_t k = 0; k < std::size(kinds); k++) {
+                clock_type::duration slowest{};
+                for (std::size_t c = 0; c < clients; c++) slowest = std::max(slowest, closed_after[k * clients + c]);
+
+                std::printf("  %s closed within %.2f s", names[k], std::chrono::duration<double>(slowest).count());
+
+                // stalled clients are closed after one timeout, give the timer a second of slack
+                if (kinds[k] != client_kind::well_behaved && slowest > std::chrono::seconds(2)) passed = false;
+            }
+            std::printf("\n");
+
+            for (std::size_t c = 0; c < clients; c++) {
+                if (!answered[3 * clients + c]) passed = false;
+            }
+        }
+
+        // the server side of the last close may still be on its way
+        for (int i = 0; i < 100 && server.open() > 0; i++) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        const auto& counters = server.get_counters();
+        auto timeouts = counters.idle_timeouts.load() + counters.header_timeouts.load() + counters.body_timeouts.load();
+
+        std::printf("\ntimeouts: idle %llu, header %llu, body %llu, write %llu (expected %zu in total)\n",
+            static_cast<unsigned long long>(counters.idle_timeouts.load()),
+            static_cast<unsigned long long>(counters.header_timeouts.load()),
+            static_cast<unsigned long long>(counters.body_timeouts.load()),
+            static_cast<unsigned long long>(counters.write_timeouts.load()),
+            stalled);
+        std::printf("connections left open: %zu\n", server.open());
+
+        if (timeouts != stalled || server.open() != 0) passed = false;
+    }
+
+    auto descriptors_after = open_descriptors();
+    std::printf("file descriptors: %zu before, %zu after\n", descriptors_before, descriptors_after);
+    if (descriptors_after > descriptors_before) passed = false;
+
+    std::printf("%s\n", passed ? "PASSED" : "FAILED");
+    return passed;
+}
+
+/*
+--------------------------- THROUGHPUT --------------------------------------
+*/
+
+/**
+ * @brief Client side of one connection, plaintext or TLS. TLS clients offer `resume` as the session
+ * to resume when it is set.
+ */
+class bench_client {
+    public:
+        bench_client(asio::io_context& context, uint16_t port, asio::ssl::context* tls, SSL_SESSION* resume)
+        : socket(context)
+        {
+            socket.connect({ asio::ip::make_address("127.0.0.1"), port });
+            socket.set_option(asio::ip::tcp::no_delay(true));
+
+            if (!tls) return;
+
+            stream.emplace(socket, *tls);
+            if (resume) SSL_set_session(stream->native_handle(), resume);
+
+            stream->handshake(asio::ssl::stream_base::client);
+            resumed = SSL_session_reused(stream->native_handle()) == 1;
+        }
+
+        ~bench_client() {
+            // OpenSSL marks the session of a connection freed without a shutdown as not resumable
+            if (stream) SSL_set_shutdown(stream->native_handle(), SSL_SENT_SHUTDOWN);
+        }
+
+        /**
+         * @brief Writes `requests` and reads `reply_bytes` back.
+         */
+        void exchange(std::string_view requests, std::size_t reply_bytes) {
+            buffer.resize(reply_bytes);
+
+            if (stream) {
+                asio::write(*stream, asio::buffer(requests));
+                asio::read(*stream, asio::buffer(buffer));
+            } else {
+                asio::write(socket, asio::buffer(requests));
+                asio::read(socket, asio::buffer(buffer));
+            }
+        }
+
+        bool was_resumed() const { return resumed; }
+
+        /**
+         * @brief Session to resume on a later connection. TLS 1.3 sends its tickets after the
+         * handshake, so take it after the first exchange.
+         */
+        SSL_SESSION* get_session() { return stream ? SSL_get1_session(stream->native_handle()) : nullptr; }
+
+    private:
+        asio::ip::tcp::socket socket;
+        std::optional<asio::ssl::stream<asio::ip::tcp::socket&>> stream;
+        std::string buffer;
+        bool resumed = false;
+};
+
+struct throughput_result {
+    double connect_us = 0;          /**< Connecting, the handshake and the first request */
+    double keep_alive_us = 0;       /**< Per request, one at a time on one connection */
+    double pipelined_us = 0;        /**< Per request, `PIPELINE_DEPTH` per write */
+    bool resumed = false;           /**< Every new connection resumed its TLS session */
+};
+
+static constexpr std::size_t PIPELINE_DEPTH = 16;
+
+static throughput_result throughput(bench_server& server, std::size_t requests, asio::ssl::context* tls, bool resume) {
+    asio::io_context context;
+    response_cache cache(std::chrono::seconds(1));
+    auto reply_bytes = cache.health().get(true)->size();
+
+    std::string pipelined;
+    for (std::size_t i = 0; i < PIPELINE_DEPTH; i++) pipelined += REQUEST;
+
+    throughput_result result;
+    SSL_SESSION* session = nullptr;
+
+    auto timed = [](std::size_t count, auto&& body){
+        auto started = clock_type::now();
+        for (std::size_t i = 0; i < count; i++) body();
+
+        return std::chrono::duration<double, std::micro>(clock_type::now() - started).count() / static_cast<double>(count);
+    };
+
+    // a handshake whose session the resumed connections reuse
+    if (resume) {
+        bench_client first(context, server.port(), tls, nullptr);
+        first.exchange(REQUEST, reply_bytes);
+        session = first.get_session();
+    }
+
+    std::size_t connections = std::max<std::size_t>(requests / 100, 10);
+    std::size_t resumed = 0;
+
+    result.connect_us = timed(connections, [&](){
+        bench_client client(context, server.port(), tls, session);
+        client.exchange(REQUEST, reply_bytes);
+        resumed += client.was_resumed();
+    });
+    result.resumed = resume && resumed == connections;
+
+    bench_client client(context, server.port(), tls, session);
+    for (std::size_t i = 0; i < 100; i++) client.exchange(REQUEST, reply_bytes);
+
+    result.keep_alive_us = timed(requests, [&](){
+        client.exchange(REQUEST, reply_bytes);
+    });
+
+    result.pipelined_us = timed(requests / PIPELINE_DEPTH, [&](){
+        client.exchange(pipelined, reply_bytes * PIPELINE_DEPTH);
+    }) / PIPELINE_DEPTH;
+
+    if (session) SSL_SESSION_free(session);
+    return result;
+}
+
+static void print_result(const char* name, const throughput_result& result) {
+    std::printf("%-14s %18.1f %18.2f %16.2f %14.0f\n", name, result.connect_us, result.keep_alive_us,
+        result.pipelined_us, 1e6 / result.keep_alive_us);
+}
+
+static bool run_throughput(std::size_t requests, const char* certificate, const char* key) {
+    std::printf("%zu requests per run\n\n", requests);
+    std::printf("%-14s %18s %18s %16s %14s\n", "", "new conn (us)", "keep-alive (us)", "pipelined (us)", "requests/s");
+
+    {
+        bench_server server(connection_options{});
+        print_result("plaintext", throughput(server, requests, nullptr, false));
+    }
+
+    if (!certificate) return true;
+
+    tls_options options;
+    options.port = 1;
+    options.certificate_file = certificate;
+    options.private_key_file = key;
+
+    tls_context server_tls(options);
+    bench_server server(connection_options{}, &server_tls);
+
+    asio::ssl::context client_tls(asio::ssl::context::tls_client);
+    client_tls.set_verify_mode(asio::ssl::verify_none);
+
+    print_result("TLS full", throughput(server, requests, &client_tls, false));
+
+    auto resumed = throughput(server, requests, &client_tls, true);
+    print_result("TLS resumed", resumed);
+
+    if (!resumed.resumed) {
+        std::printf("\nTLS sessions were not resumed\n");
+        return false;
+    }
+
+    return true;
+}
+
+/*
+--------------------------- ALLOCATIONS --------------------------------------
+*/
+
+/**
+ * @return heap allocations of the server thread per keep-alive request.
+ */
+static double allocations_per_request(reply_mode mode, std::size_t requests) {
+    bench_server server(connection_options{}, nullptr, mode);
+
+    asio::io_context context;
+    response_cache cache(std::chrono::seconds(1));
+    auto reply_bytes = cache.health().get(true)->size();
+
+    bench_client client(context, server.port(), nullptr, nullptr);
+
+    // the first requests fill the buffers and caches of the connection
+    for (std::size_t i = 0; i < 1000; i++) client.exchange(REQUEST, reply_bytes);
+
+    auto before = allocations.load();
+    for (std::size_t i = 0; i < requests; i++) client.exchange(REQUEST, reply_bytes);
+
+    return static_cast<double>(allocations.load() - before) / static_cast<double>(requests);
+}
+
+static void run_allocations(std::size_t requests) {
+    std::printf("%zu keep-alive requests, heap allocations of the server thread per request\n\n", requests);
+    std::printf("immediate reply    %6.1f\n", allocations_per_request(reply_mode::immediate, requests));
+    std::printf("spawned reply      %6.1f\n", allocations_per_request(reply_mode::spawned, requests));
+}
+
+/*
+--------------------------- WORKERS --------------------------------------
+*/
+
+/**
+ * @brief Runs `clients` threads, each sending keep-alive requests over a connection of its own,
+ * against a server run by `threads` threads, for `seconds`.
+ *
+ * @return requests per second.
+ */
+static double requests_per_second(std::size_t threads, std::size_t clients, std::chrono::seconds seconds) {
+    bench_server server(connection_options{}, nullptr, reply_mode::spawned, threads);
+
+    response_cache cache(std::chrono::seconds(1));
+    auto reply_bytes = cache.health().get(true)->size();
+
+    std::atomic<uint64_t> total{0};
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> client_threads;
+
+    for (std::size_t c = 0; c < clients; c++) {
+        client_threads.emplace_back([&](){
+            asio::io_context context;
+            bench_client client(context, server.port(), nullptr, nullptr);
+            uint64_t requests = 0;
+
+            while (!stop.load(std::memory_order_relaxed)) {
+                client.exchange(REQUEST, reply_bytes);
+                requests++;
+            }
+
+            total += requests;
+        });
+    }
+
+    std::this_thread::sleep_for(seconds);
+    stop = true;
+
+    for (auto& thread : client_threads) thread.join();
+
+    return static_cast<double>(total.load()) / static_cast<double>(seconds.count());
+}
+
+static void run_workers(std::size_t clients, std::chrono::seconds seconds) {
+    std::printf("%zu keep-alive clients, %lld s per run, %u hardware threads\n\n",
+        clients, static_cast<long long>(seconds.count()), std::thread::hardware_concurrency());
+    std::printf("%8s %14s\n", "workers", "requests/s");
+
+    for (std::size_t threads : { 1, 2, 4, 8 }) {
+        std::printf("%8zu %14.0f\n", threads, requests_per_second(threads, clients, seconds));
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string mode = argc >= 2 ? argv[1] : "";
+
+    if (mode == "workers") {
+        std::size_t clients = argc >= 3 ? std::stoull(argv[2]) : 16;
+        std::chrono::seconds seconds(argc >= 4 ? std::stoll(argv[3]) : 2);
+
+        run_workers(std::max<std::size_t>(clients, 1), std::max(seconds, std::chrono::seconds(1)));
+        return 0;
+    }
+
+    if (mode == "allocations") {
+        run_allocations(argc >= 3 ? std::stoull(argv[2]) : 100'000);
+        return 0;
+    }
+
+    if (mode == "throughput") {
+        std::size_t requests = 20'000;
+        const char* certificate = nullptr;
+        const char* key = nullptr;
+
+        for (int i = 2; i < argc; i++) {
+            std::string argument = argv[i];
+
+            if (argument == "--tls" && i + 2 < argc) {
+                certificate = argv[++i];
+                key = argv[++i];
+            } else {
+                requests = std::stoull(argument);
+            }
+        }
+
+        return run_throughput(std::max<std::size_t>(requests, PIPELINE_DEPTH), certificate, key) ? 0 : 1;
+    }
+
+    if (mode == "soak") {
+        std::size_t clients = argc >= 3 ? std::stoull(argv[2]) : 100;
+        std::chrono::seconds seconds(argc >= 4 ? std::stoll(argv[3]) : 30);
+
+        return soak(clients, seconds) ? 0 : 1;
+    }
+
+    std::fprintf(stderr, "usage: bench_connection soak [clients per kind] [seconds]\n"
+                         "       bench_connection throughput [requests] [--tls certificate.pem key.pem]\n"
+                         "       bench_connection allocations [requests]\n"
+                         "       bench_connection workers [clients] [seconds]\n");
+    return 2;
+}
@@ -0,0 +1,130 @@
+/**
+ * @author lafftale1999
+ *
+ * @brief Contention benchmark of lynks::network::queue. Producers and consumers pass items through
+ * a single queue and the throughput of every configuration is printed next to a std::deque guarded
+ * by a mutex, the queue the ring replaced. Every run checks that each item arrived exactly once.
+ *
+ * Usage: bench_queue [items per producer] [capacity]
+ */
+
+#include "network_queue.hpp"
+
+#include <cstdio>
+#include <deque>
+#include <string>
+
+using namespace lynks::network;
+
+/**
+ * @brief Bounded std::deque behind a mutex, with the interface of the ring used here.
+ */
+class locked_queue {
+    public:
+        explicit locked_queue(std::size_t capacity) : max_items(capacity) {}
+
+        bool push_back(uint64_t item) {
+            std::scoped_lock<std::mutex> lock(mtx);
+            if (items.size() >= max_items) return false;
+
+            items.push_back(item);
+            return true;
+        }
+
+        bool try_pop(uint64_t& out) {
+            std::scoped_lock<std::mutex> lock(mtx);
+            if (items.empty()) return false;
+
+            out = items.front();
+            items.pop_front();
+            return true;
+        }
+
+    private:
+        std::mutex mtx;
+        std::deque<uint64_t> items;
+        const std::size_t max_items;
+};
+
+/**
+ * @brief Runs `producers` and `consumers` threads over one queue.
+ *
+ * @return items per second, or a negative value if an item was lost or duplicated.
+ */
+template <typename Queue>
+static double run(std::size_t producers, std::size_t consumers, uint64_t items, std::size_t capacity) {
+    Queue queue(capacity);
+
+    const uint64_t total = producers * items;
+    std::atomic<uint64_t> consumed{0};
+    std::atomic<uint64_t> checksum{0};
+    std::atomic<bool> go{false};
+
+    std::vector<std::thread> threads;
+
+    for (std::size_t p = 0; p < producers; p++) {
+        threads.emplace_back([&, p](){
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+
+            for (uint64_t i = 0; i < items; i++) {
+                uint64_t item = p * items + i;
+                while (!queue.push_back(std::move(item))) std::this_thread::yield();
+            }
+        });
+    }
+
+    for (std::size_t c = 0; c < consumers; c++) {
+        threads.emplace_back([&](){
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+
+            uint64_t sum = 0;
+            uint64_t item;
+
+            while (consumed.load(std::memory_order_relaxed) < total) {
+                if (!queue.try_pop(item)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                sum += item;
+                consumed.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            checksum.fetch_add(sum);
+        });
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+
+    for (auto& thread : threads) thread.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+
+    if (checksum.load() != total * (total - 1) / 2) return -1;
+    return static_cast<double>(total) / elapsed.count();
+}
+
+int main(int argc, char** argv) {
+    uint64_t items = argc >= 2 ? std::stoull(argv[1]) : 1'000'000;
+    std::size_t capacity = argc >= 3 ? std::stoull(argv[2]) : 1024;
+
+    std::printf("%llu items per producer, capacity %zu, %u hardware threads\n\n",
+        static_cast<unsigned long long>(items), capacity, std::thread::hardware_concurrency());
+    std::printf("producers x consumers    ring (M items/s)    mutex + deque (M items/s)\n");
+
+    const std::pair<std::size_t, std::size_t> configurations[] = { {1, 1}, {2, 2}, {4, 4}, {8, 8}, {1, 8}, {8, 1} };
+
+    for (auto [producers, consumers] : configurations) {
+        double ring = run<queue<uint64_t>>(producers, consumers, items, capacity);
+        double locked = run<locked_queue>(producers, consumers, items, capacity);
+
+        if (ring < 0 || locked < 0) {
+            std::printf("%zu x %zu: items lost or duplicated\n", producers, consumers);
+            return 1;
+        }
+
+        std::printf("%9zu x %-9zu    %16.2f    %25.2f\n", producers, consumers, ring / 1e6, locked / 1e6);
+    }
+
+    return 0;
+}
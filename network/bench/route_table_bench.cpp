@@ -0,0 +1,169 @@
+/**
+ * @author lafftale1999
+ *
+ * @brief Dispatch cost of lynks::network::route_table. The routes of the router, and a table of 32
+ * routes, are looked up with a mix of hits, wrong methods, unknown paths and query strings, next to
+ * a linear scan over the same routes, which is what the if/else chain of the old router did. The
+ * tables are checked with static_asserts, so a lookup that goes wrong fails to compile.
+ *
+ * Usage: bench_route_table [lookups]
+ */
+
+#include "network_route_table.hpp"
+
+#include <cstdio>
+#include <random>
+#include <string>
+
+using namespace lynks::network;
+
+static constexpr auto ROUTES = make_route_table<int>({
+    { http::verb::post, "/login",               0, 1024, { 5, 20 },   std::chrono::seconds(3)  },
+    { http::verb::post, "/create",              1, 1024, { 2, 10 },   std::chrono::seconds(10) },
+    { http::verb::post, "/list_participants",   2, 4096, { 10, 40 },  std::chrono::seconds(5)  },
+    { http::verb::get,  "/metrics",             3, 0,    {},          {}                       },
+    { http::verb::get,  "/health",              4, 0,    {},          {}                       },
+});
+
+static_assert(ROUTES.find(http::verb::post, "/login").found->handler == 0);
+static_assert(ROUTES.find(http::verb::post, "/list_participants").found->handler == 2);
+static_assert(ROUTES.find(http::verb::get, "/health").found->handler == 4);
+static_assert(ROUTES.find(http::verb::get, "/metrics?name=lynks").found->handler == 3);
+static_assert(ROUTES.find(http::verb::get, "/login").found == nullptr);
+static_assert(ROUTES.find(http::verb::get, "/login").path != ROUTES.npos);
+static_assert(ROUTES.find(http::verb::post, "/logout").path == ROUTES.npos);
+static_assert(ROUTES.find(http::verb::post, "/log").path == ROUTES.npos);
+static_assert(ROUTES.find(http::verb::post, "").path == ROUTES.npos);
+
+static constexpr auto WIDE_ROUTES = make_route_table<int>({
+    { http::verb::get,    "/api/users",             0,  0, {}, {} },
+    { http::verb::post,   "/api/users",             1,  0, {}, {} },
+    { http::verb::get,    "/api/users/me",          2,  0, {}, {} },
+    { http::verb::put,    "/api/users/me",          3,  0, {}, {} },
+    { http::verb::delete_,"/api/users/me",          4,  0, {}, {} },
+    { http::verb::get,    "/api/rooms",             5,  0, {}, {} },
+    { http::verb::post,   "/api/rooms",             6,  0, {}, {} },
+    { http::verb::get,    "/api/rooms/active",      7,  0, {}, {} },
+    { http::verb::post,   "/api/rooms/join",        8,  0, {}, {} },
+    { http::verb::post,   "/api/rooms/leave",       9,  0, {}, {} },
+    { http::verb::get,    "/api/rooms/participants",10, 0, {}, {} },
+    { http::verb::post,   "/api/rooms/kick",        11, 0, {}, {} },
+    { http::verb::post,   "/api/rooms/mute",        12, 0, {}, {} },
+    { http::verb::post,   "/api/rooms/unmute",      13, 0, {}, {} },
+    { http::verb::get,    "/api/messages",          14, 0, {}, {} },
+    { http::verb::post,   "/api/messages",          15, 0, {}, {} },
+    { http::verb::get,    "/api/messages/unread",   16, 0, {}, {} },
+    { http::verb::post,   "/api/messages/read",     17, 0, {}, {} },
+    { http::verb::get,    "/api/contacts",          18, 0, {}, {} },
+    { http::verb::post,   "/api/contacts",          19, 0, {}, {} },
+    { http::verb::delete_,"/api/contacts",          20, 0, {}, {} },
+    { http::verb::get,    "/api/settings",          21, 0, {}, {} },
+    { http::verb::put,    "/api/settings",          22, 0, {}, {} },
+    { http::verb::post,   "/login",                 23, 0, {}, {} },
+    { http::verb::post,   "/logout",                24, 0, {}, {} },
+    { http::verb::post,   "/refresh",               25, 0, {}, {} },
+    { http::verb::post,   "/create",                26, 0, {}, {} },
+    { http::verb::post,   "/list_participants",     27, 0, {}, {} },
+    { http::verb::get,    "/metrics",               28, 0, {}, {} },
+    { http::verb::get,    "/health",                29, 0, {}, {} },
+    { http::verb::get,    "/ready",                 30, 0, {}, {} },
+    { http::verb::get,    "/version",               31, 0, {}, {} },
+});
+
+static_assert(WIDE_ROUTES.find(http::verb::delete_, "/api/users/me").found->handler == 4);
+static_assert(WIDE_ROUTES.find(http::verb::get, "/version").found->handler == 31);
+static_assert(WIDE_ROUTES.find(http::verb::patch, "/api/settings").found == nullptr);
+static_assert(WIDE_ROUTES.find(http::verb::patch, "/api/settings").path != WIDE_ROUTES.npos);
+static_assert(WIDE_ROUTES.find(http::verb::get, "/api/user").path == WIDE_ROUTES.npos);
+
+struct request_line {
+    http::verb method;
+    std::string target;
+};
+
+/**
+ * @brief Known routes, some with a query string, followed by wrong methods and unknown paths,
+ * shuffled into `count` lookups.
+ */
+template <typename Table>
+static std::vector<request_line> make_requests(const Table& table, std::size_t count) {
+    std::vector<request_line> lines;
+
+    for (const auto& entry : table.get_routes()) {
+        lines.push_back({ entry.method, std::string(entry.path) });
+        lines.push_back({ entry.method, std::string(entry.path) + "?page=2" });
+    }
+
+    lines.push_back({ http::verb::patch, std::string(table.get_routes()[0].path) });
+    lines.push_back({ http::verb::get, "/favicon.ico" });
+    lines.push_back({ http::verb::get, "/" });
+
+    std::vector<request_line> requests;
+    requests.reserve(count);
+
+    std::mt19937 random(42);
+    for (std::size_t i = 0; i < count; i++) requests.push_back(lines[random() % lines.size()]);
+
+    return requests;
+}
+
+/**
+ * @brief The route table searched from the first route to the last, like an if/else chain.
+ */
+template <typename Table>
+static const route<int>* linear_find(const Table& table, http::verb method, std::string_view target) {
+    std::string_view path = Table::strip_query(target);
+
+    for (const auto& entry : table.get_routes()) {
+        if (entry.path == path && entry.method == method) return &entry;
+    }
+
+    return nullptr;
+}
+
+/**
+ * @return nanoseconds per lookup.
+ */
+template <typename Find>
+static double measure(const std::vector<request_line>& requests, Find&& find) {
+    int64_t sink = 0;
+
+    auto started = std::chrono::steady_clock::now();
+    for (const auto& request : requests) {
+        const route<int>* found = find(request.method, request.target);
+        sink += found ? found->handler : -1;
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - started;
+
+    // keeps the loop from being optimized away
+    if (sink == INT64_MIN) std::printf("%lld\n", static_cast<long long>(sink));
+
+    return elapsed.count() / static_cast<double>(requests.size());
+}
+
+template <typename Table>
+static void run(const char* name, const Table& table, std::size_t lookups) {
+    auto requests = make_requests(table, lookups);
+
+    double hashed = measure(requests, [&table](http::verb method, std::string_view target){
+        return table.find(method, target).found;
+    });
+
+    double linear = measure(requests, [&table](http::verb method, std::string_view target){
+        return linear_find(table, method, target);
+    });
+
+    std::printf("%-10s %6zu routes    route_table %6.1f ns    linear scan %6.1f ns\n",
+        name, table.get_routes().size(), hashed, linear);
+}
+
+int main(int argc, char** argv) {
+    std::size_t lookups = argc >= 2 ? std::stoull(argv[1]) : 10'000'000;
+
+    std::printf("%zu lookups per table, time per lookup\n\n", lookups);
+
+    run("router", ROUTES, lookups);
+    run("wide", WIDE_ROUTES, lookups);
+
+    return 0;
+}
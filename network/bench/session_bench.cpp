@@ -0,0 +1,286 @@
+/**
+ * @author lafftale1999
+ *
+ * @brief Lookup cost of lynks::network::session_handler. Sessions are created through new_session()
+ * like a login does and looked up with resolve() like an authenticated request does.
+ *
+ * Usage:
+ *   bench_session size [largest]
+ *     Times hits and misses at 1k, 10k, 100k and 1M sessions, up to `largest`, next to a linear
+ *     scan over a std::vector behind a mutex, the store the hash table replaced.
+ *
+ *   bench_session threads [sessions]
+ *     Runs 1 to 32 threads resolving random tokens while a writer adds a session and expires due
+ *     sessions every 5 ms, next to one session_table behind one mutex, the store before striping.
+ */
+
+#include "network_session_handler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+
+using namespace lynks::network;
+using clock_type = std::chrono::steady_clock;
+
+/**
+ * @brief Sessions in a std::vector searched by token under a mutex, like session_handler before
+ * the hash table.
+ */
+class locked_vector {
+    public:
+        void add(std::string token, session_principal principal) {
+            std::scoped_lock<std::mutex> lock(mtx);
+            sessions.push_back({ std::move(token), std::move(principal) });
+        }
+
+        std::optional<session_principal> resolve(const std::string& token) {
+            std::scoped_lock<std::mutex> lock(mtx);
+
+            auto it = std::find_if(sessions.begin(), sessions.end(), [&token](const auto& session){
+                return session.first == token;
+            });
+
+            if (it == sessions.end()) return std::nullopt;
+            return it->second;
+        }
+
+    private:
+        std::mutex mtx;
+        std::vector<std::pair<std::string, session_principal>> sessions;
+};
+
+/**
+ * @brief Runs `lookup` over `tokens` in random order for at least 200 ms.
+ *
+ * @return nanoseconds per lookup.
+ */
+template <typename Lookup>
+static double measure(const std::vector<std::string>& tokens, Lookup&& lookup) {
+    std::mt19937_64 random(42);
+    std::size_t lookups = 0;
+    std::size_t found = 0;
+
+    auto started = clock_type::now();
+    auto elapsed = clock_type::duration::zero();
+
+    while (elapsed < std::chrono::milliseconds(200)) {
+        for (int i = 0; i < 16; i++) {
+            found += lookup(tokens[random() % tokens.size()]).has_value();
+        }
+
+        lookups += 16;
+        elapsed = clock_type::now() - started;
+    }
+
+    // keeps the lookups from being optimized away
+    if (found == SIZE_MAX) std::printf("%zu\n", found);
+
+    return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(lookups);
+}
+
+/**
+ * @brief Well-formed tokens no session was created with.
+ */
+static std::vector<std::string> unknown_tokens(std::size_t count) {
+    static constexpr char HEX[] = "0123456789abcdef";
+
+    std::mt19937_64 random(7);
+    std::vector<std::string> tokens(count, std::string(64, '0'));
+
+    for (auto& token : tokens) {
+        for (auto& c : token) c = HEX[random() % 16];
+    }
+
+    return tokens;
+}
+
+static void print_time(double ns) {
+    if (ns >= 1e6) std::printf("%10.1f ms", ns / 1e6);
+    else if (ns >= 1e3) std::printf("%10.2f us", ns / 1e3);
+    else std::printf("%10.0f ns", ns);
+}
+
+static bool run_size(std::size_t largest) {
+    std::printf("time per resolve(), random tokens\n\n");
+    std::printf("%10s %13s %13s %13s\n", "sessions", "hash hit", "hash miss", "vector hit");
+
+    auto misses = unknown_tokens(1024);
+
+    for (std::size_t sessions = 1000; sessions <= largest; sessions *= 10) {
+        session_handler handler(sessions);
+        locked_vector vector;
+
+        std::vector<std::string> tokens;
+        tokens.reserve(sessions);
+
+        for (std::size_t i = 0; i < sessions; i++) {
+            session_principal principal{ static_cast<int64_t>(i), "user" + std::to_string(i) };
+
+            auto token = handler.new_session(principal);
+            if (!token) {
+                std::printf("session %zu of %zu was refused\n", i, sessions);
+                return false;
+            }
+
+            vector.add(*token, principal);
+            tokens.push_back(std::move(*token));
+        }
+
+        double hit = measure(tokens, [&handler](const std::string& token){ return handler.resolve(token); });
+        double miss = measure(misses, [&handler](const std::string& token){ return handler.resolve(token); });
+        double scan = measure(tokens, [&vector](const std::string& token){ return vector.resolve(token); });
+
+        std::printf("%10zu ", sessions);
+        print_time(hit);
+        print_time(miss);
+        print_time(scan);
+        std::printf("\n");
+    }
+
+    return true;
+}
+
+/*
+--------------------------- THREADS --------------------------------------
+*/
+
+/**
+ * @brief One session_table behind one mutex taken by readers and writers alike, like the session
+ * store before it was striped.
+ */
+class locked_table {
+    public:
+        explicit locked_table(std::size_t capacity) : table(capacity) {}
+
+        void add(const std::string& token, session_principal principal) {
+            std::scoped_lock<std::mutex> lock(mtx);
+            table.insert(*parse_token(token), std::move(principal));
+        }
+
+        std::optional<session_principal> resolve(const std::string& token) {
+            auto key = parse_token(token);
+            if (!key) return std::nullopt;
+
+            std::scoped_lock<std::mutex> lock(mtx);
+            return table.with_session(*key, [](session_token* session) -> std::optional<session_principal> {
+                if (!session || !session->validate_token()) return std::nullopt;
+                return session->get_principal();
+            });
+        }
+
+        void expire() {
+            std::scoped_lock<std::mutex> lock(mtx);
+            table.expire(session_token::get_now_ms());
+        }
+
+    private:
+        std::mutex mtx;
+        session_table table;
+};
+
+/**
+ * @brief Runs `threads` readers for half a second while a writer adds a session and expires
+ * sessions every 5 ms.
+ *
+ * @return lookups per second.
+ */
+template <typename Resolve, typename Write>
+static double contend(int threads, const std::vector<std::string>& tokens, Resolve&& resolve, Write&& write) {
+    std::atomic<uint64_t> total{0};
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> readers;
+
+    for (int t = 0; t < threads; t++) {
+        readers.emplace_back([&, t](){
+            std::mt19937_64 random(t);
+            uint64_t lookups = 0;
+
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (int i = 0; i < 64; i++) resolve(tokens[random() % tokens.size()]);
+                lookups += 64;
+            }
+
+            total += lookups;
+        });
+    }
+
+    std::thread writer([&](){
+        for (std::size_t i = 0; !stop.load(); i++) {
+            write(i);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    stop = true;
+
+    for (auto& reader : readers) reader.join();
+    writer.join();
+
+    return static_cast<double>(total.load()) / 0.5;
+}
+
+static bool run_threads(std::size_t sessions) {
+    // room for the sessions the writers add
+    session_handler handler(sessions + 1024);
+    locked_table locked(sessions + 1024);
+    auto added = unknown_tokens(1024);
+
+    std::vector<std::string> tokens;
+    tokens.reserve(sessions);
+
+    for (std::size_t i = 0; i < sessions; i++) {
+        session_principal principal{ static_cast<int64_t>(i), "user" + std::to_string(i) };
+
+        auto token = handler.new_session(principal);
+        if (!token) {
+            std::printf("session %zu of %zu was refused\n", i, sessions);
+            return false;
+        }
+
+        locked.add(*token, principal);
+        tokens.push_back(std::move(*token));
+    }
+
+    std::printf("%zu sessions, random resolve() hits, %u hardware threads\n\n", sessions, std::thread::hardware_concurrency());
+    std::printf("%8s %18s %18s\n", "threads", "striped (M/s)", "one mutex (M/s)");
+
+    for (int threads : { 1, 2, 4, 8, 16, 32 }) {
+        double striped = contend(threads, tokens,
+            [&handler](const std::string& token){ return handler.resolve(token); },
+            [&handler](std::size_t i){
+                handler.new_session({ -1, "writer" + std::to_string(i) });
+                handler.expire_sessions();
+            });
+
+        double mutex = contend(threads, tokens,
+            [&locked](const std::string& token){ return locked.resolve(token); },
+            [&locked, &added](std::size_t i){
+                locked.add(added[i % added.size()], { -1, "writer" + std::to_string(i) });
+                locked.expire();
+            });
+
+        std::printf("%8d %18.2f %18.2f\n", threads, striped / 1e6, mutex / 1e6);
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::string mode = argc >= 2 ? argv[1] : "";
+
+    if (mode == "size") {
+        return run_size(argc >= 3 ? std::stoull(argv[2]) : 1'000'000) ? 0 : 1;
+    }
+
+    if (mode == "threads") {
+        return run_threads(argc >= 3 ? std::stoull(argv[2]) : 100'000) ? 0 : 1;
+    }
+
+    std::fprintf(stderr, "usage: bench_session size [largest]\n"
+                         "       bench_session threads [sessions]\n");
+    return 2;
+}
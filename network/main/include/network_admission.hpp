@@ -0,0 +1,188 @@
+/**
+ * @author lafftale1999
+ *
+ * @brief Defines lynks::network::admission_control, the per-client limits of the server. It caps the
+ * connections a single address may hold open and runs token buckets per address and per address and
+ * route, so a single misbehaving client is answered with a pre-serialized `429` instead of reaching
+ * the router, the database or the password hashing of `/login`.
+ */
+
+#ifndef NETWORK_ADMISSION_HPP_
+#define NETWORK_ADMISSION_HPP_
+
+#include "network_common.hpp"
+#include "network_metrics.hpp"
+
+#include <array>
+
+namespace lynks::network {
+
+    /**
+     * @brief Token bucket refilled with `per_second` tokens up to `burst`. Unlimited while `per_second` is 0.
+     */
+    struct rate_limit {
+        double per_second = 0;
+        double burst = 0;
+
+        constexpr bool limited() const { return per_second > 0; }
+    };
+
+    /**
+     * @brief Route a request is admitted for, with the limit of its own bucket.
+     */
+    struct route_limit {
+        static constexpr std::size_t NO_ROUTE = static_cast<std::size_t>(-1);
+
+        std::size_t route = NO_ROUTE;   /**< Index of the route, `NO_ROUTE` for unknown routes */
+        rate_limit rate;                /**< Bucket per client and route, applied next to the one of the client */
+    };
+
+    /**
+     * @brief Outcome of `admission_control::try_connect()`.
+     */
+    enum class connect_verdict {
+        rejected,       /**< The address holds its maximum of connections */
+        counted,        /**< Admitted and counted, give it back with `disconnect()` */
+        untracked       /**< Admitted without being counted, the cap is off or the set of the address is full */
+    };
+
+    /**
+     * @brief Limits applied to every client address. IPv6 clients are grouped by their /64 prefix,
+     * which is what a single host is usually handed.
+     *
+     * Behind a proxy every client arrives from the address of the proxy, which turns these limits
+     * into a single cap for the whole service. They should be disabled there.
+     */
+    struct admission_options {
+        std::size_t max_connections_per_client = 256;       /**< Open connections per address, 0 disables the cap */
+        rate_limit requests_per_client{ 200, 400 };         /**< Requests per address over every route, unlimited at 0 per second */
+        bool route_limits = true;                           /**< Apply the per-route buckets of the route table */
+        std::size_t tracked_entries = 16384;                /**< Size of the table, one entry per client and per client and route */
+        std::chrono::seconds idle_eviction{60};             /**< Entries idle this long without connections are reused */
+    };
+
+    /**
+     * @brief Connection caps and token buckets per client, kept in a fixed-size table. Thread-safe.
+     *
+     * The table is set-associative: a key hashes to a set of `WAYS` entries guarded by a spinlock of
+     * its own, so callers only ever contend on the same set and hold it for a few instructions. A new
+     * key takes a free entry of its set, or one idle for `idle_eviction`, or else the least recently
+     * used one holding no connections. A set whose entries all hold connections admits the key
+     * untracked rather than rejecting it.
+     */
+    class admission_control {
+        public:
+            explicit admission_control(const admission_options& options);
+
+            admission_control(const admission_control&) = delete;
+            admission_control& operator=(const admission_control&) = delete;
+
+            /**
+             * @brief Counts a new connection of `client`.
+             *
+             * @return `rejected` if `client` already holds `max_connections_per_client` connections,
+             * `untracked` if the connection was admitted without being counted. The caller keeps the
+             * verdict, so only a `counted` connection is given back.
+             */
+            connect_verdict try_connect(const asio::ip::address& client);
+
+            /**
+             * @brief Gives back the connection of a `try_connect(client)` that returned `counted`.
+             */
+            void disconnect(const asio::ip::address& client);
+
+            /**
+             * @brief Takes a token from the bucket of `client` and, for known routes with a limit,
+             * from the bucket of `client` on `route`.
+             *
+             * @return `false` if either bucket is empty.
+             */
+            bool try_request(const asio::ip::address& client, const route_limit& route);
+
+        private:
+            static constexpr std::size_t WAYS = 8;
+            static constexpr uint32_t CLIENT_SCOPE = 0;    /**< Scope of the connection count and bucket of a client, routes use `route + 1` */
+
+            struct key {
+                uint64_t high = 0;
+                uint64_t low = 0;
+                uint32_t scope = 0;
+
+                bool operator==(const key&) const = default;
+            };
+
+            struct entry {
+                key id;
+                bool used = false;
+                uint32_t connections = 0;
+                float tokens = 0;
+                int64_t last = 0;      /**< Last refill, in steady clock nanoseconds */
+            };
+
+            struct alignas(64) entry_set {
+                std::atomic_flag lock;
+                std::array<entry, WAYS> entries;
+            };
+
+            /**
+             * @brief Holds the lock of a set for one operation.
+             */
+            class set_lock {
+                public:
+                    explicit set_lock(entry_set& set) : set(set) {
+                        while (set.lock.test_and_set(std::memory_order_acquire)) std::this_thread::yield();
+                    }
+
+                    ~set_lock() { set.lock.clear(std::memory_order_release); }
+
+                    set_lock(const set_lock&) = delete;
+                    set_lock& operator=(const set_lock&) = delete;
+
+                private:
+                    entry_set& set;
+            };
+
+            static key make_key(const asio::ip::address& client, uint32_t scope);
+
+            entry_set& set_of(const key& id);
+
+            /**
+             * @brief Finds the entry of `id` in `set`, claiming one for it when `claim` is set.
+             * Must be called with the set locked.
+             *
+             * @return the entry, or `nullptr` if it is not tracked.
+             */
+            entry* find(entry_set& set, const key& id, int64_t now, const rate_limit& limit, bool claim);
+
+            /**
+             * @brief Refills the bucket of `slot` for the time passed since its last refill.
+             */
+            static void refill(entry& slot, const rate_limit& limit, int64_t now);
+
+            /**
+             * @brief Takes a token from the bucket of `id`, `true` if the key is not limited or untracked.
+             */
+            bool take_token(const key& id, const rate_limit& limit, int64_t now);
+
+            static int64_t now_ns() {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            }
+
+            void write_metrics(std::string& out) const;
+
+        private:
+            const admission_options options;
+            const int64_t idle_eviction_ns;
+            std::unique_ptr<entry_set[]> sets;
+            const std::size_t set_mask;
+
+            sharded_counter rejected_connections;
+            sharded_counter rejected_client_rate;
+            sharded_counter rejected_route_rate;
+            sharded_counter untracked;
+
+            metrics_source metrics;
+    };
+}
+
+#endif
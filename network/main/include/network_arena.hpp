@@ -0,0 +1,148 @@
+/**
+ * @author lafftale1999
+ *
+ * @brief Defines lynks::network::request_arena, the memory a single request and its response are
+ * allocated from, and lynks::network::arena_pool, which recycles the arenas of a connection. The
+ * header fields, target and body of a parsed request and of the response built for it are carved out
+ * of one monotonic buffer, and everything is released in one shot once the response is written.
+ */
+
+#ifndef NETWORK_ARENA_HPP_
+#define NETWORK_ARENA_HPP_
+
+#include "network_common.hpp"
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace lynks::network {
+
+    /**
+     * @brief Allocator drawing from a `std::pmr::memory_resource`, the heap by default.
+     *
+     * Unlike `std::pmr::polymorphic_allocator` it is assignable, which Beast requires of the allocator
+     * of `basic_fields`, and it travels with moved messages, so moving a request or response never
+     * copies it. Copies are allocated from the heap, since nothing would keep the arena alive for them.
+     */
+    template <typename T>
+    class arena_allocator {
+        public:
+            using value_type = T;
+            using propagate_on_container_move_assignment = std::true_type;
+            using propagate_on_container_swap = std::true_type;
+
+            arena_allocator() noexcept = default;
+            explicit arena_allocator(std::pmr::memory_resource* resource) noexcept : resource(resource) {}
+
+            template <typename U>
+            arena_allocator(const arena_allocator<U>& other) noexcept : resource(other.get_resource()) {}
+
+            T* allocate(std::size_t count) {
+                return static_cast<T*>(resource->allocate(count * sizeof(T), alignof(T)));
+            }
+
+            void deallocate(T* pointer, std::size_t count) noexcept {
+                resource->deallocate(pointer, count * sizeof(T), alignof(T));
+            }
+
+            arena_allocator select_on_container_copy_construction() const noexcept {
+                return arena_allocator();
+            }
+
+            std::pmr::memory_resource* get_resource() const noexcept {
+                return resource;
+            }
+
+            template <typename U>
+            bool operator==(const arena_allocator<U>& other) const noexcept {
+                return resource == other.get_resource();
+            }
+
+        private:
+            std::pmr::memory_resource* resource = std::pmr::new_delete_resource();
+    };
+
+    /* Requests read by the server and the responses built for them allocate from the arena of the request */
+    using request_allocator = arena_allocator<char>;
+    using arena_string_body = http::basic_string_body<char, std::char_traits<char>, request_allocator>;
+    using arena_fields = http::basic_fields<request_allocator>;
+    using server_request = http::request<arena_string_body, arena_fields>;
+    using server_response = http::response<arena_string_body, arena_fields>;
+
+    /**
+     * @brief Monotonic arena of one request. Allocations are a pointer bump into an inline buffer,
+     * deallocations are no-ops, and anything past the inline buffer is taken from the heap in growing
+     * chunks and given back by `reset()`.
+     *
+     * @attention Not thread-safe. Only the request and response of the arena may allocate from it,
+     * which never happens concurrently since both are handled on the strand of their connection.
+     */
+    class request_arena {
+        public:
+            static constexpr std::size_t INLINE_SIZE = 8 * 1024;
+
+            request_arena() = default;
+
+            request_arena(const request_arena&) = delete;
+            request_arena& operator=(const request_arena&) = delete;
+
+            request_allocator get_allocator() {
+                return request_allocator(&memory);
+            }
+
+            /**
+             * @brief Releases everything allocated from the arena. Nothing allocated from it may be
+             * alive anymore.
+             */
+            void reset() {
+                memory.release();
+            }
+
+        private:
+            alignas(std::max_align_t) std::byte initial[INLINE_SIZE];
+            std::pmr::monotonic_buffer_resource memory{initial, sizeof(initial), std::pmr::new_delete_resource()};
+    };
+
+    /**
+     * @brief Arenas of one connection.
+     *
+     * Every request handle and response handle holds a reference to its arena, so an arena is only
+     * reused once every message allocated from it is destroyed, whichever thread that happens on.
+     * A connection needs about as many arenas as it allows pipelined requests.
+     */
+    class arena_pool {
+        public:
+            /**
+             * @param max_pooled arenas kept for reuse, arenas handed out past it are freed once unused.
+             */
+            explicit arena_pool(std::size_t max_pooled) : max_pooled(max_pooled) {}
+
+            /**
+             * @brief Returns an empty arena, reusing one no message refers to anymore.
+             *
+             * @attention Must be called on the executor of the connection.
+             */
+            std::shared_ptr<request_arena> acquire() {
+                for (auto& arena : arenas) {
+                    if (arena.use_count() == 1) {
+                        // pairs with the release of the last reference dropped on another thread
+                        std::atomic_thread_fence(std::memory_order_acquire);
+
+                        arena->reset();
+                        return arena;
+                    }
+                }
+
+                auto arena = std::make_shared<request_arena>();
+                if (arenas.size() < max_pooled) arenas.push_back(arena);
+
+                return arena;
+            }
+
+        private:
+            std::vector<std::shared_ptr<request_arena>> arenas;
+            std::size_t max_pooled;
+    };
+}
+
+#endif
@@ -0,0 +1,73 @@
+/**
+ * @author lafftale1999
+ *
+ * @brief Defines lynks::network::request_backlog, a lock-free admission counter bounding the amount of
+ * requests, and the bytes they occupy, that the server has accepted but not yet answered. Requests
+ * over the limit are shed by the caller instead of queuing up behind the ones already in progress.
+ */
+
+#ifndef NETWORK_BACKLOG_HPP_
+#define NETWORK_BACKLOG_HPP_
+
+#include "network_common.hpp"
+
+namespace lynks::network {
+
+    /**
+     * @brief Bounded counter of requests in progress, measured in requests and bytes.
+     */
+    class request_backlog {
+        public:
+            /**
+             * @param max_requests maximum amount of requests in progress at the same time.
+             * @param max_bytes maximum amount of request bytes in progress at the same time.
+             */
+            request_backlog(std::size_t max_requests, std::size_t max_bytes)
+            : max_requests(max_requests), max_bytes(max_bytes) {}
+
+            /**
+             * @brief Reserves room for a request of `size` bytes.
+             *
+             * @return `false` if either limit would be exceeded. The request is then counted as shed
+             * and nothing is reserved.
+             */
+            bool try_acquire(std::size_t size) {
+                if (in_flight.fetch_add(1, std::memory_order_relaxed) >= max_requests) {
+                    in_flight.fetch_sub(1, std::memory_order_relaxed);
+                    shed.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+
+                if (in_flight_bytes.fetch_add(size, std::memory_order_relaxed) + size > max_bytes) {
+                    in_flight_bytes.fetch_sub(size, std::memory_order_relaxed);
+                    in_flight.fetch_sub(1, std::memory_order_relaxed);
+                    shed.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+
+                return true;
+            }
+
+            /**
+             * @brief Gives back the room reserved by a successful `try_acquire(size)`.
+             */
+            void release(std::size_t size) {
+                in_flight_bytes.fetch_sub(size, std::memory_order_relaxed);
+                in_flight.fetch_sub(1, std::memory_order_relaxed);
+            }
+
+            std::size_t get_requests() const { return in_flight.load(std::memory_order_relaxed); }
+            std::size_t get_bytes() const { return in_flight_bytes.load(std::memory_order_relaxed); }
+            uint64_t get_shed_count() const { return shed.load(std::memory_order_relaxed); }
+
+        private:
+            const std::size_t max_requests;
+            const std::size_t max_bytes;
+
+            std::atomic<std::size_t> in_flight{0};
+            std::atomic<std::size_t> in_flight_bytes{0};
+            std::atomic<uint64_t> shed{0};
+    };
+}
+
+#endif
@@ -19,6 +19,7 @@
 #include <cstdint>
 #include <cmath>
 #include <map>
+#include <atomic>
 
 #define BOOST_CHARCONV_HEADER_ONLY
 
@@ -35,6 +36,4 @@ using http_response = http::response<http::string_body>;
 
 namespace asio = boost::asio;
 
-#define LYNKS_BACKEND_DEBUG
-
 #endif
\ No newline at end of file
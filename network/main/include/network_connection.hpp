@@ -3,8 +3,8 @@
  * 
  * @brief Defines the lynks::network::connection class, which represents a single asynchronous TCP 
  * connection between the HTTP server and a client. It is responsible for managing the full lifetime 
- * of a client connection, including reading incoming HTTP requests, forwarding them into a shared 
- * request queue for processing, and serializing outgoing HTTP responses back to the client.
+ * of a client connection, including reading incoming HTTP requests, handing them to the request 
+ * dispatcher of the server for processing, and serializing outgoing HTTP responses back to the client.
  */
 
 #ifndef NETWORK_CONNECTION_HPP_
@@ -12,9 +12,105 @@
 
 #include "network_queue.hpp"
 #include "network_message_handler.hpp"
+#include "network_response_cache.hpp"
+#include "network_logger.hpp"
+#include "network_tls.hpp"
+#include "network_arena.hpp"
+
+#include <cstring>
+#include <functional>
 
 namespace lynks {
     namespace network {
+        class connection;
+
+        /**
+         * @brief Callback receiving every parsed request of a connection. Invoked on the executor
+         * (strand) of the connection that produced the request.
+         */
+        using request_dispatcher = std::function<void(std::shared_ptr<connection>, message_handle<server_request>&)>;
+
+        /**
+         * @brief Callback invoked exactly once when the read loop of a connection ends.
+         */
+        using disconnect_handler = std::function<void(std::shared_ptr<connection>)>;
+
+        /**
+         * @brief Verdict on a request header, given before the body of the request is read.
+         */
+        struct header_verdict {
+            const cached_reply* reject = nullptr;   /**< Sent instead of reading the body when set */
+            std::uint64_t body_limit = 0;           /**< Largest body accepted for the request */
+        };
+
+        /**
+         * @brief Callback inspecting every request header, used to reject unknown routes and to pick
+         * the body limit of the route before the body is read. Invoked on the executor of the connection.
+         */
+        using header_inspector = std::function<header_verdict(const server_request&)>;
+
+        /**
+         * @brief Callbacks through which a connection talks to its server.
+         */
+        struct connection_hooks {
+            request_dispatcher  dispatch;       /**< Receives every complete request */
+            header_inspector    inspect;        /**< Optional, accepts every header with `max_body_size` when empty */
+            disconnect_handler  on_disconnect;  /**< Called once the connection closes */
+        };
+
+        /**
+         * @brief Tunables for a single client connection.
+         */
+        struct connection_options {
+            std::size_t max_pipelined_requests = 16;                                          /**< Requests read ahead before their responses are written */
+            std::chrono::steady_clock::duration handshake_timeout = std::chrono::seconds(10); /**< Completing the TLS handshake */
+            std::chrono::steady_clock::duration idle_timeout = std::chrono::seconds(60);      /**< Waiting for the first byte of a request */
+            std::chrono::steady_clock::duration header_timeout = std::chrono::seconds(10);    /**< Reading the rest of the request header */
+            std::chrono::steady_clock::duration body_timeout = std::chrono::seconds(30);      /**< Reading the request body */
+            std::chrono::steady_clock::duration write_timeout = std::chrono::seconds(30);     /**< Writing one batch of responses */
+            std::uint64_t max_body_size = 1 << 20;                                            /**< Body limit while the header is read and when no inspector is set */
+            std::size_t max_write_batch_bytes = 64 * 1024;                                    /**< Responses gathered into one write, the first is always taken */
+            bool tcp_no_delay = true;                                                         /**< Disables Nagle, batches are written whole so nothing is gained by delaying */
+            bool tcp_cork = false;                                                            /**< Corks the socket while the writer is busy (Linux only) */
+        };
+
+        /**
+         * @brief Counters shared by every connection of a server. Used to observe slow-client pressure.
+         */
+        struct connection_counters {
+            std::atomic<uint64_t> handshake_timeouts{0};/**< Connections closed during the TLS handshake */
+            std::atomic<uint64_t> idle_timeouts{0};     /**< Connections closed while idle */
+            std::atomic<uint64_t> header_timeouts{0};   /**< Connections closed while reading a header */
+            std::atomic<uint64_t> body_timeouts{0};     /**< Connections closed while reading a body */
+            std::atomic<uint64_t> write_timeouts{0};    /**< Connections closed while writing a response */
+            std::atomic<uint64_t> cancelled_requests{0};/**< Requests whose work was cancelled because their client went away */
+        };
+
+        /**
+         * @brief A response on its way to the client. Either a dynamic server_response, pre-serialized
+         * bytes written as they are, or wire bytes rendered from a response_template into the body of
+         * `message`. Route handlers answer with it, the server fills in the sequence.
+         */
+        struct outgoing_response {
+            message_handle<server_response> message;        /**< Dynamic response, also carries the sequence */
+            serialized_response             serialized;     /**< Pre-serialized wire bytes, used instead of `message` when set */
+            bool                            rendered = false; /**< The body of `message` holds the complete wire bytes */
+
+            /**
+             * @brief Status code of the response. Wire bytes always start with the status line.
+             */
+            unsigned status() const {
+                if (!serialized && !rendered) return message.data.result_int();
+
+                const auto& body = message.data.body();
+                std::string_view wire = serialized ? std::string_view(*serialized) : std::string_view(body.data(), body.size());
+
+                // "HTTP/1.1 200 "
+                if (wire.size() < 12) return 0;
+                return static_cast<unsigned>((wire[9] - '0') * 100 + (wire[10] - '0') * 10 + (wire[11] - '0'));
+            }
+        };
+
         /**
          * @brief The connection between server and client.
          * 
@@ -26,27 +122,56 @@ namespace lynks {
                 /**
                  * @brief Instantiates the connection.
                  * 
-                 * @param context& reference to the context in which the connection is used.
-                 * @param socket the socket to which the client is connected.
-                 * @param requests& reference to the requests queue. This is used for pushing incoming requests to.
+                 * @param socket the socket to which the client is connected. The socket should be bound to
+                 * a strand, since every handler of the connection is dispatched on the sockets executor.
+                 * It is wrapped in a `tcp_stream`, whose expiry enforces the timeouts in `options`.
+                 * @param hooks callbacks into the server. `dispatch` either hands the request straight to the
+                 * router or pushes it into the shared requests queue, `inspect` judges each header before the
+                 * body is read and `on_disconnect` removes the connection from the server right away.
+                 * @param counters& timeout counters shared by all connections of the server.
+                 * @param cache& pre-serialized replies the connection sends on its own, such as `413`.
+                 * @param options tunables such as the amount of pipelined requests allowed in flight.
+                 * @param tls the TLS context of the listener that accepted the socket, `nullptr` for plain TCP.
+                 * The connection performs the server handshake before it reads its first request.
                  */
-                connection(asio::io_context& context, asio::ip::tcp::socket socket, queue<owned_message_handle<http_request>>& requests) 
-                : socket(std::move(socket)), context(context), requests(requests) 
-                {}
+                connection(
+                    asio::ip::tcp::socket socket,
+                    connection_hooks hooks,
+                    connection_counters& counters,
+                    const response_cache& cache,
+                    connection_options options = {},
+                    tls_context* tls = nullptr
+                ) 
+                : stream(std::move(socket)), hooks(std::move(hooks)), counters(counters), cache(cache),
+                  options(sanitize(options)), tls(tls), responses(this->options.max_pipelined_requests),
+                  arenas(this->options.max_pipelined_requests + 2), cancellations(this->options.max_pipelined_requests)
+                {
+                    if (tls) tls_stream.emplace(stream, tls->get_context());
+
+                    // never reallocated while a write is in progress, the serializers refer into it
+                    batch.reserve(this->options.max_pipelined_requests);
+
+                    boost::system::error_code ec;
+                    stream.socket().set_option(asio::ip::tcp::no_delay(this->options.tcp_no_delay), ec);
+                }
                 
                 virtual ~connection() {
-                    disconnect();
+                    boost::system::error_code ec;
+                    stream.socket().close(ec);
                 }
 
                 /**
-                 * @brief Checks if the client is connected and calls `read_request()`.
+                 * @brief Checks if the client is connected and calls `read_request()`, after the TLS
+                 * handshake on a TLS connection.
                  * 
                  * @param uid unique id. 0 as default.
                  */
                 void connect_to_client(uint32_t uid = 0) {
-                    if (socket.is_open()) {
+                    if (stream.socket().is_open()) {
                         id = uid;
-                        read_request();
+
+                        if (tls_stream) handshake();
+                        else read_request();
                     }
                 }
 
@@ -55,32 +180,85 @@ namespace lynks {
                  */
                 void disconnect() {
                     if (is_connected()) {
-                        boost::asio::post(context, [this](){ socket.close(); });
+                        boost::asio::post(stream.get_executor(), [self = this->shared_from_this()](){
+                            self->close();
+                        });
                     }
                 }
 
+                /**
+                 * @brief Stops reading new requests. The connection closes once the responses its
+                 * client is still waiting for are written, or right away if there are none.
+                 * 
+                 * Shutting down the receiving side makes the pending read end with `eof`, which takes
+                 * the same path as a client that stopped sending.
+                 */
+                void drain() {
+                    boost::asio::post(stream.get_executor(), [self = this->shared_from_this()](){
+                        self->draining = true;
+
+                        boost::system::error_code ec;
+                        self->stream.socket().shutdown(asio::ip::tcp::socket::shutdown_receive, ec);
+                    });
+                }
+
                 /**
                  * @brief Checks if the socket is open.
                  * 
                  * @return `bool`
                  */
                 bool is_connected() const {
-                    return socket.is_open();
+                    return stream.socket().is_open();
                 }
 
                 /**
-                 * @brief Sends the response to the client.
+                 * @brief Sends the response to the client. Responses may arrive in any order, they are
+                 * written in the order their requests were read based on `response.sequence`.
+                 * 
+                 * Safe to call from any thread.
                  * 
-                 * @param response& the message_handle used to send messages to the client.
+                 * @param response the message_handle used to send messages to the client. Must carry the
+                 * `sequence` of the request it answers. Moved into the `responses` queue.
                  */
-                void send_response(const lynks::network::message_handle<http_response>& response) {
-                    boost::asio::post(context, [this, response]() {
-                        bool is_writing = !responses.is_empty();
-                        responses.push_back(response);
-                        if (!is_writing) write_response();
+                void send_response(lynks::network::message_handle<server_response> response) {
+                    send_response(outgoing_response{ std::move(response), nullptr });
+                }
+
+                /**
+                 * @brief Sends a dynamic, pre-serialized or rendered response. Same as above, `sequence`
+                 * is taken from `response.message`.
+                 */
+                void send_response(outgoing_response response) {
+                    if (!responses.push_back(std::move(response))) {
+                        LYNKS_LOG_WARNING("CONNECTION", "[" << id << "] response queue full, closing connection");
+                        disconnect();
+                        return;
+                    }
+
+                    boost::asio::post(stream.get_executor(), [self = this->shared_from_this()]() {
+                        self->collect_responses();
                     });
                 }
 
+                /**
+                 * @brief Sends pre-serialized bytes as the response to the request with `sequence`.
+                 * Used for fixed replies that skip the router entirely, such as load shedding.
+                 * 
+                 * @attention Must be called on the executor of the connection, for example from the
+                 * request dispatcher.
+                 * 
+                 * @param sequence the sequence of the request being answered.
+                 * @param serialized the complete response, shared and never modified.
+                 */
+                void send_serialized(uint32_t sequence, serialized_response serialized) {
+                    if (!place_response(outgoing_response{ message_handle<server_response>{ .sequence = sequence }, std::move(serialized) })) {
+                        close();
+                        return;
+                    }
+
+                    if (!is_writing && !holding_writes) write_response();
+                }
+
                 /**
                  * @brief returns the current connection id.
                  * 
@@ -90,7 +268,77 @@ namespace lynks {
                     return id;
                 }
 
+                /**
+                 * @brief Returns the executor (strand) that serializes all work on this connection.
+                 * Coroutines handling requests for this client should be spawned on it.
+                 */
+                asio::any_io_executor get_executor() {
+                    return stream.get_executor();
+                }
+
+                /**
+                 * @brief Returns the cancellation slot of the request with `sequence`. It is emitted when the
+                 * client goes away before the request is answered, so the coroutine handling the request
+                 * should be bound to it and clear it once done.
+                 * 
+                 * @attention Must be called on the executor of the connection.
+                 */
+                asio::cancellation_slot request_slot(uint32_t sequence) {
+                    // at most `max_pipelined_requests` consecutive sequences are in flight, each has its own signal
+                    return cancellations[sequence % cancellations.size()].slot();
+                }
+
             private:
+                /**
+                 * @brief The part of a request the read loop is waiting for. Decides which
+                 * timeout applies and which counter is bumped when it expires.
+                 */
+                enum class read_phase {
+                    idle,
+                    header,
+                    body
+                };
+
+                /**
+                 * @brief Runs `operation` on the TLS stream of the connection, or on the plain
+                 * `tcp_stream` if the connection is not encrypted. Both layers share the expiry
+                 * of `stream`, so the timeouts apply the same way to either.
+                 */
+                template <typename Operation>
+                void with_stream(Operation&& operation) {
+                    if (tls_stream) operation(*tls_stream);
+                    else operation(stream);
+                }
+
+                /**
+                 * @brief
+                 * 
+                 * -- ASYNC --
+                 * 
+                 * Performs the server side TLS handshake, bounded by `options.handshake_timeout`, and
+                 * starts the read loop. Returning clients resume their session through a ticket or the
+                 * session cache of `tls`.
+                 */
+                void handshake() {
+                    auto started = std::chrono::steady_clock::now();
+
+                    stream.expires_after(options.handshake_timeout);
+                    tls_stream->async_handshake(asio::ssl::stream_base::server,
+                    [this, self = this->shared_from_this(), started](boost::beast::error_code ec){
+                        if (ec) {
+                            tls->handshake_failed();
+                            if (ec == boost::beast::error::timeout) counters.handshake_timeouts++;
+
+                            LYNKS_LOG_DEBUG("CONNECTION", "[" << id << "] TLS handshake failed: " << ec.message());
+                            close();
+                            return;
+                        }
+
+                        tls->handshake_done(tls_stream->native_handle(), std::chrono::steady_clock::now() - started);
+                        read_request();
+                    });
+                }
+
                 /**
                  * @brief 
                  * 
@@ -99,69 +347,590 @@ namespace lynks {
                  * Reads incoming requests and calls `add_to_incoming_requests`.
                  * Utilizes the field `request`, which is populated by this method.
                  * 
-                 * If the reading fails, the connection will close.
+                 * If the reading fails, the connection will close and `on_disconnect` is called.
+                 * The loop stops by itself after a request asking to close the connection, and pauses
+                 * while `options.max_pipelined_requests` requests are waiting for their responses.
+                 * 
+                 * Waiting for the first byte of a request is bounded by `options.idle_timeout`. Bytes
+                 * already buffered from a pipelining client skip straight to `read_header()`. While a
+                 * whole header is buffered, responses are held back so the responses to a burst of
+                 * pipelined requests are written together. They are flushed before waiting on the client.
                  */
                 void read_request() {
-                    boost::beast::http::async_read(socket, buffer, request.data,
-                    [this](boost::beast::error_code ec, std::size_t length){
-                        if (!ec) {
-                            add_to_incoming_requests();
-                        } else if (ec == boost::beast::http::error::end_of_stream) {
-                            std::cout << "[" << id << "]" << " connection closed: " << ec.message() << std::endl;
-                            socket.shutdown(asio::ip::tcp::socket::shutdown_both);
-                            socket.close();
+                    if (buffer.size() > 0) {
+                        holding_writes = has_buffered_header();
+                        if (!holding_writes) flush_responses();
+
+                        read_header();
+                        return;
+                    }
+
+                    flush_responses();
+
+                    stream.expires_after(options.idle_timeout);
+                    with_stream([this](auto& layer){
+                        layer.async_read_some(buffer.prepare(IDLE_READ_SIZE),
+                        [this, self = this->shared_from_this()](boost::beast::error_code ec, std::size_t length){
+                            if (ec) {
+                                on_read_error(ec, read_phase::idle);
+                                return;
+                            }
+
+                            buffer.commit(length);
+                            read_header();
+                        });
+                    });
+                }
+
+                /**
+                 * @brief
+                 * 
+                 * -- ASYNC --
+                 * 
+                 * Reads the request header into a fresh `parser`, bounded by `options.header_timeout`,
+                 * and hands it to `inspect_header()`. The request is allocated from an arena of `arenas`.
+                 */
+                void read_header() {
+                    // let go of the arena of the previous request first, a rejected one can be reused right away
+                    parser.reset();
+                    arena.reset();
+                    arena = arenas.acquire();
+
+                    auto allocator = arena->get_allocator();
+                    parser.emplace(std::piecewise_construct, std::make_tuple(allocator), std::make_tuple(allocator));
+                    // the limit of the route is applied once the header is inspected. `boost::none` is not used
+                    // here since older Beast versions compare the content length against it and always fail
+                    parser->body_limit(std::numeric_limits<std::uint64_t>::max());
+
+                    stream.expires_after(options.header_timeout);
+                    with_stream([this](auto& layer){
+                        boost::beast::http::async_read_header(layer, buffer, *parser,
+                        [this, self = this->shared_from_this()](boost::beast::error_code ec, std::size_t){
+                            if (ec) {
+                                on_read_error(ec, read_phase::header);
+                                return;
+                            }
+
+                            inspect_header();
+                        });
+                    });
+                }
+
+                /**
+                 * @brief Judges the header before any of the body is read. Unknown routes, bad methods,
+                 * bodies over the limit of the route and unsupported expectations are answered with a
+                 * pre-serialized reply. `Expect: 100-continue` is answered before the body is read.
+                 */
+                void inspect_header() {
+                    const auto& header = parser->get();
+                    bool body_pending = !parser->is_done();
+
+                    header_verdict verdict{ nullptr, options.max_body_size };
+                    if (hooks.inspect) verdict = hooks.inspect(header);
+
+                    if (verdict.reject) {
+                        reject_request(*verdict.reject, header.keep_alive() && !body_pending);
+                        return;
+                    }
+
+                    auto length = parser->content_length();
+                    if (length && *length > verdict.body_limit) {
+                        reject_request(cache.payload_too_large(), false);
+                        return;
+                    }
+
+                    parser->body_limit(verdict.body_limit);
+
+                    auto expect = header.find(http::field::expect);
+                    if (expect != header.end()) {
+                        if (!boost::beast::iequals(expect->value(), "100-continue")) {
+                            reject_request(cache.expectation_failed(), header.keep_alive() && !body_pending);
+                            return;
                         }
-                        else {
-                            std::cout << "[" << id << "] read request failed" << std::endl;
-                            std::cerr << ec.message() << std::endl;
-                            socket.shutdown(asio::ip::tcp::socket::shutdown_both);
-                            socket.close();
+
+                        if (body_pending) {
+                            send_continue();
+                            return;
                         }
+                    }
+
+                    read_body();
+                }
+
+                /**
+                 * @brief
+                 * 
+                 * -- ASYNC --
+                 * 
+                 * Writes `100 Continue` and then reads the body. Only done while nothing else is being
+                 * written, since the interim response must not overtake earlier responses. Otherwise
+                 * the body is read right away, which the client handles by sending it after a delay.
+                 */
+                void send_continue() {
+                    if (is_writing || in_flight > 0) {
+                        read_body();
+                        return;
+                    }
+
+                    is_writing = true;
+                    stream.expires_after(options.write_timeout);
+                    with_stream([this](auto& layer){
+                        asio::async_write(layer, asio::buffer(CONTINUE_RESPONSE.data(), CONTINUE_RESPONSE.size()),
+                        [this, self = this->shared_from_this()](boost::beast::error_code ec, std::size_t){
+                            is_writing = false;
+
+                            if (ec) {
+                                if (ec == boost::beast::error::timeout) counters.write_timeouts++;
+                                close();
+                                return;
+                            }
+
+                            read_body();
+                        });
+                    });
+                }
+
+                /**
+                 * @brief Answers the current request with a pre-serialized reply instead of dispatching it.
+                 * 
+                 * @param reply& the fixed reply to send.
+                 * @param keep_alive if the connection may continue. Must be `false` when the body of the
+                 * request has not been read, since it would otherwise be parsed as the next request.
+                 */
+                void reject_request(const cached_reply& reply, bool keep_alive) {
+                    uint32_t sequence = next_sequence++;
+                    in_flight++;
+                    if (!keep_alive) close_sequence = sequence;
+
+                    send_serialized(sequence, reply.get(keep_alive));
+
+                    if (keep_alive) continue_reading();
+                    else flush_responses();
+                }
+
+                /**
+                 * @brief
+                 * 
+                 * -- ASYNC --
+                 * 
+                 * Reads the request body, bounded by `options.body_timeout` and the limit chosen in
+                 * `inspect_header()`, and hands the finished request to `add_to_incoming_requests()`.
+                 */
+                void read_body() {
+                    if (parser->is_done()) {
+                        add_to_incoming_requests();
+                        return;
+                    }
+
+                    // a body already buffered is parsed without waiting on the client
+                    auto remaining = parser->content_length_remaining();
+                    if (!remaining || *remaining > buffer.size()) flush_responses();
+
+                    stream.expires_after(options.body_timeout);
+                    with_stream([this](auto& layer){
+                        boost::beast::http::async_read(layer, buffer, *parser,
+                        [this, self = this->shared_from_this()](boost::beast::error_code ec, std::size_t){
+                            if (ec) {
+                                on_read_error(ec, read_phase::body);
+                                return;
+                            }
+
+                            add_to_incoming_requests();
+                        });
                     });
                 }
 
                 /**
-                 * @brief Pushes the incoming request to the shared `requests`-queue.
+                 * @brief Ends the read loop. Counts timeouts, and lets the writer finish the responses
+                 * the client is still waiting for if the client only stopped sending.
+                 */
+                void on_read_error(boost::beast::error_code ec, read_phase phase) {
+                    if (ec == http::error::body_limit) {
+                        reject_request(cache.payload_too_large(), false);
+                        return;
+                    }
+
+                    if (ec == boost::beast::error::timeout) {
+                        switch (phase) {
+                            case read_phase::idle:      counters.idle_timeouts++;   break;
+                            case read_phase::header:    counters.header_timeouts++; break;
+                            case read_phase::body:      counters.body_timeouts++;   break;
+                        }
+
+                        LYNKS_LOG_DEBUG("CONNECTION", "[" << id << "] read timed out");
+                    } else if (ec == boost::beast::http::error::end_of_stream || ec == asio::error::eof ||
+                               ec == asio::ssl::error::stream_truncated) {
+                        LYNKS_LOG_DEBUG("CONNECTION", "[" << id << "] connection closed: " << ec.message());
+
+                        // a draining server finishes writing what the client is still waiting for, a client
+                        // that hung up on its own is not waiting and its requests are cancelled in close()
+                        if (in_flight > 0 && draining) {
+                            close_sequence = next_sequence - 1;
+                            flush_responses();
+                            return;
+                        }
+                    } else {
+                        LYNKS_LOG_WARNING("CONNECTION", "[" << id << "] read request failed: " << ec.message());
+                    }
+
+                    close();
+                }
+
+                /**
+                 * @brief Shuts down and closes the socket, then hands the connection to `on_disconnect`.
+                 * Safe to call more than once, `on_disconnect` is only called the first time.
+                 * 
+                 * TLS connections are closed without a `close_notify`. Every response is framed by its
+                 * length, so the client cannot mistake a truncated response for a complete one.
+                 */
+                void close() {
+                    boost::system::error_code ec;
+                    stream.socket().shutdown(asio::ip::tcp::socket::shutdown_both, ec);
+                    stream.socket().close(ec);
+
+                    cancel_requests();
+
+                    if (hooks.on_disconnect) {
+                        auto handler = std::move(hooks.on_disconnect);
+                        hooks.on_disconnect = nullptr;
+                        handler(this->shared_from_this());
+                    }
+                }
+
+                /**
+                 * @brief Cancels the work of every request still being handled. Nothing can be written to
+                 * the client anymore, so the database and Janus operations they wait on are aborted and
+                 * their connections released instead of running to completion.
+                 */
+                void cancel_requests() {
+                    for (auto& signal : cancellations) {
+                        if (!signal.slot().has_handler()) continue;
+
+                        counters.cancelled_requests++;
+                        signal.emit(asio::cancellation_type::terminal);
+                    }
+                }
+
+                /**
+                 * @brief Tags the incoming request with its sequence number, hands it to `hooks.dispatch`
+                 * and starts reading the next one unless the client asked to close or the pipeline is full.
                  */
                 void add_to_incoming_requests() {
-                    auto msg = std::move(request);
-                    requests.push_back({ this->shared_from_this(), msg });
-                    request = {};
+                    message_handle<server_request> msg{ .arena = std::move(arena), .data = parser->release() };
+
+                    msg.sequence = next_sequence++;
+                    msg.received = std::chrono::steady_clock::now();
+                    bool keep_alive = msg.data.keep_alive();
+                    if (!keep_alive) close_sequence = msg.sequence;
+                    in_flight++;
+
+                    hooks.dispatch(this->shared_from_this(), msg);
+
+                    if (keep_alive) continue_reading();
+                    else flush_responses();
+                }
+
+                /**
+                 * @brief Starts reading the next request, or pauses the read loop while the pipeline is full.
+                 */
+                void continue_reading() {
+                    if (in_flight >= options.max_pipelined_requests) {
+                        read_paused = true;
+                        flush_responses();
+                        return;
+                    }
+
                     read_request();
                 }
 
+                /**
+                 * @brief Moves every response handed to `send_response()` into its slot in `pending`
+                 * and starts the writer if it is idle.
+                 */
+                void collect_responses() {
+                    outgoing_response response;
+
+                    while (responses.try_pop(response)) {
+                        if (!place_response(std::move(response))) {
+                            close();
+                            return;
+                        }
+                    }
+
+                    if (!is_writing && !holding_writes) write_response();
+                }
+
+                /**
+                 * @brief Stops holding back responses and starts the writer if it is idle.
+                 */
+                void flush_responses() {
+                    holding_writes = false;
+                    if (!is_writing) write_response();
+                }
+
+                /**
+                 * @brief Checks if `buffer` holds the complete header of the next request, which is
+                 * then parsed without waiting on the client.
+                 */
+                bool has_buffered_header() const {
+                    auto data = buffer.data();
+                    std::string_view buffered(static_cast<const char*>(data.data()), data.size());
+
+                    return buffered.find("\r\n\r\n") != std::string_view::npos;
+                }
+
+                /**
+                 * @brief Puts the response into its slot of `pending` based on its sequence.
+                 * 
+                 * @return `false` if the sequence belongs to no request in flight. The request it was
+                 * meant for keeps its pipeline slot and the responses after it can no longer be put in
+                 * order, so the caller closes the connection.
+                 */
+                bool place_response(outgoing_response response) {
+                    uint32_t offset = response.message.sequence - next_to_write;
+                    if (offset >= options.max_pipelined_requests) {
+                        LYNKS_LOG_ERROR("CONNECTION", "[" << id << "] response with unexpected sequence " << response.message.sequence
+                            << ", closing the connection");
+                        return false;
+                    }
+
+                    if (pending.size() <= offset) pending.resize(offset + 1);
+                    pending[offset] = std::move(response);
+                    return true;
+                }
+
                 /**
                  * @brief
                  * 
                  * -- ASYNC --
                  * 
-                 * Keeps writing responses from `responses` until the queue is empty.
+                 * Keeps writing responses in request order until the next one in line has not been
+                 * produced yet. Every response already waiting in line is moved into `batch` and sent
+                 * with a single gathering write, up to `options.max_write_batch_bytes`. After the
+                 * response to a request asking to close, the connection is closed.
                  */
                 void write_response() {
-                    boost::beast::http::async_write(socket, responses.front().data,
-                    [this](boost::beast::error_code ec, std::size_t length){
-                        if (!ec) {
-                            responses.pop_front();
-
-                            if (!responses.is_empty()) write_response();
-                        } else {
-                            std::cout << "[" << id << "] failed to write response" << std::endl;
-                            std::cerr << "Error message: " << ec.message() << std::endl;
-                            socket.close();
+                    if (pending.empty() || !pending.front()) {
+                        is_writing = false;
+                        set_cork(false);
+                        return;
+                    }
+
+                    std::size_t bytes = 0;
+                    bool last = false;
+
+                    // the first response is always taken, however large it is
+                    while (!last && !pending.empty() && pending.front() && (batch.empty() || bytes < options.max_write_batch_bytes)) {
+                        auto& response = batch.emplace_back(std::move(*pending.front()));
+                        pending.pop_front();
+                        next_to_write++;
+
+                        last = close_sequence && *close_sequence == response.message.sequence;
+                        bytes += gather_response(response, last);
+                    }
+
+                    coalesce_buffers();
+
+                    is_writing = true;
+                    set_cork(true);
+                    stream.expires_after(options.write_timeout);
+
+                    with_stream([this, last](auto& layer){
+                        asio::async_write(layer, gather,
+                        [this, self = this->shared_from_this(), last](boost::beast::error_code ec, std::size_t){
+                            on_batch_written(ec, last);
+                        });
+                    });
+                }
+
+                /**
+                 * @brief Appends the wire buffers of `response` to `gather` and returns their size.
+                 * Dynamic responses are serialized in place, `last` is raised if the response itself
+                 * closes the connection.
+                 * 
+                 * A string body with a known length comes out of the serializer in one step, header
+                 * and body together, so the buffers stay valid as long as the serializer is alive.
+                 */
+                std::size_t gather_response(outgoing_response& response, bool& last) {
+                    if (response.serialized) {
+                        gather.push_back(asio::buffer(*response.serialized));
+                        copyable.push_back(false);
+                        return response.serialized->size();
+                    }
+
+                    if (response.rendered) {
+                        const auto& wire = response.message.data.body();
+                        gather.push_back(asio::buffer(wire.data(), wire.size()));
+                        copyable.push_back(false);
+                        return wire.size();
+                    }
+
+                    auto& message = response.message.data;
+                    last = last || !message.keep_alive();
+                    message.keep_alive(!last);
+
+                    std::size_t bytes = 0;
+                    boost::beast::error_code ec;
+
+                    serializers.emplace_back(message).next(ec, [this, &bytes](boost::beast::error_code&, const auto& buffers){
+                        for (asio::const_buffer buffer : boost::beast::buffers_range_ref(buffers)) {
+                            gather.push_back(buffer);
+                            copyable.push_back(true);
+                            bytes += buffer.size();
                         }
                     });
+
+                    return bytes;
+                }
+
+                /**
+                 * @brief Copies the small buffers of `gather` into `write_buffer`, merging neighbours, so
+                 * a batch takes a few iovecs instead of one per header field. Asio only passes a limited
+                 * number of buffers to a single `sendmsg`. Only the pieces of serialized dynamic responses
+                 * are copied, and only below `COPY_LIMIT` bytes. Pre-serialized and rendered replies are
+                 * already one buffer each and are written from where they are. On TLS, where asio
+                 * encrypts every buffer into a record of its own, a batch of more than one buffer is
+                 * copied whole, while a batch of a single buffer is still written as it is.
+                 */
+                void coalesce_buffers() {
+                    bool copy_all = tls_stream && gather.size() > 1;
+
+                    auto copy = [this, copy_all](std::size_t i){
+                        return copy_all || (copyable[i] && gather[i].size() < COPY_LIMIT);
+                    };
+
+                    std::size_t copied = 0;
+                    for (std::size_t i = 0; i < gather.size(); i++) {
+                        if (copy(i)) copied += gather[i].size();
+                    }
+
+                    if (copied == 0) return;
+
+                    write_buffer.consume(write_buffer.size());
+                    char* out = static_cast<char*>(write_buffer.prepare(copied).data());
+                    write_buffer.commit(copied);
+
+                    std::size_t kept = 0;
+                    bool merge = false;
+
+                    for (std::size_t i = 0; i < gather.size(); i++) {
+                        asio::const_buffer buffer = gather[i];
+
+                        if (!copy(i)) {
+                            gather[kept++] = buffer;
+                            merge = false;
+                            continue;
+                        }
+
+                        std::memcpy(out, buffer.data(), buffer.size());
+
+                        if (merge) gather[kept - 1] = asio::const_buffer(gather[kept - 1].data(), gather[kept - 1].size() + buffer.size());
+                        else gather[kept++] = asio::const_buffer(out, buffer.size());
+
+                        out += buffer.size();
+                        merge = true;
+                    }
+
+                    gather.resize(kept);
+                }
+
+                /**
+                 * @brief Completion of a batch write. Resumes a paused read loop and continues with
+                 * the next batch, or closes after the last response.
+                 */
+                void on_batch_written(boost::beast::error_code ec, bool last) {
+                    std::size_t written = batch.size();
+
+                    // the serializers refer to the messages of the batch, they go first
+                    gather.clear();
+                    copyable.clear();
+                    serializers.clear();
+                    batch.clear();
+
+                    if (ec) {
+                        if (ec == boost::beast::error::timeout) counters.write_timeouts++;
+
+                        LYNKS_LOG_WARNING("CONNECTION", "[" << id << "] failed to write response: " << ec.message());
+                        is_writing = false;
+                        close();
+                        return;
+                    }
+
+                    in_flight -= written;
+
+                    if (last || (close_sequence && in_flight == 0)) {
+                        is_writing = false;
+                        close();
+                        return;
+                    }
+
+                    is_writing = false;
+
+                    if (read_paused) {
+                        read_paused = false;
+                        read_request();
+                    }
+
+                    if (!is_writing && !holding_writes) write_response();
+                }
+
+                /**
+                 * @brief Corks the socket while the writer is busy if `options.tcp_cork` is set, so
+                 * consecutive batches leave in full segments. Uncorking flushes what is left.
+                 */
+                void set_cork(bool enabled) {
+#ifdef TCP_CORK
+                    if (!options.tcp_cork) return;
+
+                    boost::system::error_code ec;
+                    stream.socket().set_option(asio::detail::socket_option::boolean<IPPROTO_TCP, TCP_CORK>(enabled), ec);
+#else
+                    (void)enabled;
+#endif
+                }
+
+                static connection_options sanitize(connection_options options) {
+                    options.max_pipelined_requests = std::max<std::size_t>(options.max_pipelined_requests, 1);
+                    return options;
                 }
 
             private:
-                asio::ip::tcp::socket socket;
-                asio::io_context& context;
+                boost::beast::tcp_stream stream;
+                std::optional<asio::ssl::stream<boost::beast::tcp_stream&>> tls_stream;    /**< Layered over `stream` on TLS connections */
+
+                connection_hooks hooks;
+                connection_counters& counters;
+                const response_cache& cache;
+                connection_options options;
+                tls_context* tls;
 
-                lynks::network::queue<lynks::network::owned_message_handle<http_request>>& requests;
-                lynks::network::queue<lynks::network::message_handle<http_response>> responses;
+                lynks::network::queue<outgoing_response> responses;                                 /**< Hand-off from any thread */
+                std::deque<std::optional<outgoing_response>> pending;                               /**< Reorder buffer, front is `next_to_write` */
+                std::vector<outgoing_response> batch;                                               /**< Responses of the write in progress */
+                std::deque<http::serializer<false, arena_string_body, arena_fields>> serializers;   /**< Serializers of the dynamic responses in `batch` */
+                std::vector<asio::const_buffer> gather;                                             /**< Wire buffers of `batch`, written in one call */
+                std::vector<bool> copyable;                                                         /**< Per buffer of `gather`, whether it came from a serializer */
+                boost::beast::flat_buffer write_buffer;                                             /**< Small buffers of `gather`, copied together */
+                bool is_writing = false;
+                bool holding_writes = false;            /**< Responses are held while buffered requests are parsed */
 
-                uint32_t id;
-                lynks::network::message_handle<http_request> request;
+                uint32_t next_sequence = 0;             /**< Sequence assigned to the next request read */
+                uint32_t next_to_write = 0;             /**< Sequence of the next response to write */
+                std::size_t in_flight = 0;              /**< Requests read whose response is not written yet */
+                bool read_paused = false;               /**< Reading stopped because the pipeline is full */
+                bool draining = false;                  /**< The server shut down the receiving side in `drain()` */
+                std::optional<uint32_t> close_sequence; /**< Request after which the connection closes */
+
+                uint32_t id = 0;
+                arena_pool arenas;                      /**< Arenas of the requests in flight, recycled once their responses are written */
+                std::shared_ptr<request_arena> arena;   /**< Arena of the request being read */
+                std::vector<asio::cancellation_signal> cancellations;  /**< One per request in flight, indexed by sequence */
+                std::optional<http::request_parser<arena_string_body, request_allocator>> parser;
                 boost::beast::flat_buffer buffer;
+
+                static constexpr std::size_t IDLE_READ_SIZE = 1024;
+                static constexpr std::size_t COPY_LIMIT = 1024;    /**< Smaller serializer buffers are copied into `write_buffer` before a write */
+                static constexpr std::string_view CONTINUE_RESPONSE = "HTTP/1.1 100 Continue\r\n\r\n";
         };
     } // network
 } // lynks
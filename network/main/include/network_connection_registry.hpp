@@ -0,0 +1,101 @@
+/**
+ * @author lafftale1999
+ *
+ * @brief Defines lynks::network::connection_registry, a slot map holding every live client connection
+ * of the server. Connections are keyed by a 32-bit id made of a slot index and a generation tag, which
+ * gives O(1) insert, lookup and removal, and makes sure a stale id never resolves to a newer connection
+ * that reused the same slot.
+ */
+
+#ifndef NETWORK_CONNECTION_REGISTRY_HPP_
+#define NETWORK_CONNECTION_REGISTRY_HPP_
+
+#include "network_common.hpp"
+
+#include <functional>
+
+namespace lynks::network {
+
+    /* Forward declaration of the connection class */
+    class connection;
+
+    /**
+     * @brief Thread-safe slot map of live connections.
+     *
+     * The id handed out by `insert()` stores the slot index in the lower `INDEX_BITS` bits and the
+     * generation of the slot in the upper bits. Every time a slot is freed its generation is bumped,
+     * so ids of removed connections stop matching.
+     */
+    class connection_registry {
+        public:
+            /**
+             * @param initial_capacity amount of slots reserved up front.
+             */
+            explicit connection_registry(std::size_t initial_capacity = 256);
+
+            /**
+             * @brief Stores the connection in a free slot.
+             *
+             * @param client the connection to store.
+             *
+             * @return the generation-tagged id of the connection or std::nullopt if every
+             * slot is taken.
+             */
+            std::optional<uint32_t> insert(std::shared_ptr<connection> client);
+
+            /**
+             * @brief Looks up a connection by its id.
+             *
+             * @return the connection or `nullptr` if the id is unknown or stale.
+             */
+            std::shared_ptr<connection> find(uint32_t id) const;
+
+            /**
+             * @brief Removes the connection with the given id and frees its slot.
+             *
+             * @return `true` if a connection was removed, `false` if the id is unknown or stale.
+             */
+            bool erase(uint32_t id);
+
+            /**
+             * @brief Amount of connections currently stored.
+             */
+            std::size_t live_count() const;
+
+            /**
+             * @brief Calls `fn` for every live connection.
+             *
+             * @attention `fn` is called while holding the registry lock and must not call back
+             * into the registry. Use `snapshot()` for anything heavier.
+             */
+            void for_each(const std::function<void(const std::shared_ptr<connection>&)>& fn) const;
+
+            /**
+             * @brief Copies out every live connection.
+             */
+            std::vector<std::shared_ptr<connection>> snapshot() const;
+
+        private:
+            struct slot {
+                std::shared_ptr<connection> client;
+                uint32_t generation = 1;
+            };
+
+            static uint32_t slot_index(uint32_t id);
+            static uint32_t slot_generation(uint32_t id);
+            static uint32_t make_id(uint32_t index, uint32_t generation);
+
+        private:
+            std::vector<slot> slots;
+            std::vector<uint32_t> free_slots;
+            std::atomic<std::size_t> live{0};
+            mutable std::mutex mtx;
+
+            static constexpr uint32_t INDEX_BITS = 20;
+            static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+            static constexpr uint32_t GENERATION_MASK = (1u << (32 - INDEX_BITS)) - 1;
+            static constexpr std::size_t MAX_SLOTS = std::size_t(1) << INDEX_BITS;
+    };
+}
+
+#endif
@@ -0,0 +1,36 @@
+/**
+ * @author lafftale1999
+ *
+ * @brief Defines lynks::network::request_deadline, the point in time a request has to be answered by.
+ * The router sets it per route from the moment the request was read, and every layer below passes it
+ * on, so each database and Janus operation is cancelled once the budget of its request is spent.
+ */
+
+#ifndef NETWORK_DEADLINE_HPP_
+#define NETWORK_DEADLINE_HPP_
+
+#include "network_common.hpp"
+
+namespace lynks::network {
+
+    /**
+     * @brief Point in time a request has to be answered by. `NO_DEADLINE` for work not tied to a request.
+     */
+    using request_deadline = std::chrono::steady_clock::time_point;
+
+    static constexpr request_deadline NO_DEADLINE = request_deadline::max();
+
+    /**
+     * @brief Deadline of a single step, its own limit `step` bounded by the deadline of the request.
+     * Used with `asio::cancel_at()`, which cancels the step through its cancellation slot.
+     */
+    inline request_deadline step_deadline(request_deadline deadline, std::chrono::steady_clock::duration step) {
+        return std::min(deadline, std::chrono::steady_clock::now() + step);
+    }
+
+    inline bool has_expired(request_deadline deadline) {
+        return deadline != NO_DEADLINE && std::chrono::steady_clock::now() >= deadline;
+    }
+}
+
+#endif
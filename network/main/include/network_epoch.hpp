@@ -0,0 +1,79 @@
+/**
+ * @author lafftale1999
+ *
+ * @brief Defines lynks::network::epoch_domain, grace periods for memory read without locks. Readers
+ * announce themselves for the epoch they started in, and a writer that unlinked memory waits in
+ * `synchronize()` until every reader that may still hold a pointer to it has left, before freeing it.
+ */
+
+#ifndef NETWORK_EPOCH_HPP_
+#define NETWORK_EPOCH_HPP_
+
+#include "network_common.hpp"
+
+#include <array>
+
+namespace lynks::network {
+
+    /**
+     * @brief Epoch-based reclamation for one structure with a single writer at a time.
+     *
+     * Readers count themselves in one of two counters, picked by the parity of the epoch they
+     * entered in. `synchronize()` moves the epoch forward and waits for the counter of the previous
+     * epoch to drain. Readers entering after the move cannot see memory unlinked before it.
+     */
+    class alignas(64) epoch_domain {
+        public:
+            /**
+             * @brief Marks the calling thread as reading for as long as it lives. Pointers loaded
+             * while it is held stay valid until it is destroyed.
+             */
+            class read_guard {
+                public:
+                    explicit read_guard(epoch_domain& domain) {
+                        while (true) {
+                            auto epoch = domain.epoch.load();
+                            auto& readers = domain.readers[epoch & 1];
+                            readers.fetch_add(1);
+
+                            // a writer may have moved on between the load and the count, try again
+                            if (domain.epoch.load() == epoch) {
+                                counted = &readers;
+                                return;
+                            }
+
+                            readers.fetch_sub(1, std::memory_order_release);
+                        }
+                    }
+
+                    ~read_guard() {
+                        counted->fetch_sub(1, std::memory_order_release);
+                    }
+
+                    read_guard(const read_guard&) = delete;
+                    read_guard& operator=(const read_guard&) = delete;
+
+                private:
+                    std::atomic<uint64_t>* counted = nullptr;
+            };
+
+            /**
+             * @brief Waits until no reader can hold memory unlinked before the call. Calls must not
+             * overlap, and must not be made while holding a `read_guard` of the same domain.
+             */
+            void synchronize() {
+                auto previous = epoch.load(std::memory_order_relaxed);
+                epoch.store(previous + 1);
+
+                while (readers[previous & 1].load(std::memory_order_acquire) != 0) {
+                    std::this_thread::yield();
+                }
+            }
+
+        private:
+            std::atomic<uint64_t> epoch{0};
+            std::array<std::atomic<uint64_t>, 2> readers{};
+    };
+}
+
+#endif
@@ -0,0 +1,178 @@
+/**
+ * @author lafftale1999
+ *
+ * @brief Defines lynks::network::logger, an asynchronous logger shared by the whole backend. Every
+ * thread formats its lines into its own lock-free ring buffer and a background thread drains the
+ * buffers and writes them out in batches, so logging never flushes a stream or takes a lock on the
+ * calling thread.
+ *
+ * Lines are written through the `LYNKS_LOG_*` macros. Debug lines are compiled out entirely unless
+ * `LYNKS_BACKEND_DEBUG` is defined, the other levels are filtered at runtime with `set_level()`.
+ */
+
+#ifndef NETWORK_LOGGER_HPP_
+#define NETWORK_LOGGER_HPP_
+
+#include "network_common.hpp"
+
+#include <array>
+#include <condition_variable>
+#include <ostream>
+#include <streambuf>
+#include <string_view>
+
+namespace lynks::network {
+
+    enum class log_level : uint8_t {
+        debug,
+        info,
+        warning,
+        error,
+        off
+    };
+
+    /**
+     * @brief Parses `debug`, `info`, `warning`, `error` or `off`.
+     *
+     * @return the level or `std::nullopt` if the name is unknown.
+     */
+    std::optional<log_level> parse_log_level(std::string_view name);
+
+    /**
+     * @brief Process wide asynchronous logger.
+     *
+     * Each thread owns a single-producer/single-consumer ring of fixed-size records. A full ring
+     * drops the line and counts it instead of blocking the caller. Lines longer than `MAX_LINE`
+     * are truncated. Lines from different threads are written in the order they are drained,
+     * every line carries its own timestamp.
+     */
+    class logger {
+        public:
+            static constexpr std::size_t MAX_LINE = 480;
+            static constexpr std::size_t MAX_TAG = 15;
+            static constexpr std::size_t RING_CAPACITY = 256;
+
+            /**
+             * @brief The logger of the process, started on first use.
+             */
+            static logger& instance();
+
+            logger(const logger&) = delete;
+            logger& operator=(const logger&) = delete;
+
+            ~logger();
+
+            void set_level(log_level level) { min_level.store(level, std::memory_order_relaxed); }
+            log_level get_level() const { return min_level.load(std::memory_order_relaxed); }
+
+            bool enabled(log_level level) const {
+                return level >= min_level.load(std::memory_order_relaxed);
+            }
+
+            /**
+             * @brief Returns the line stream of the calling thread, emptied. Used by the macros.
+             */
+            std::ostream& begin_line();
+
+            /**
+             * @brief Moves the line formatted since `begin_line()` into the ring of the calling thread.
+             */
+            void commit_line(log_level level, std::string_view tag);
+
+            /**
+             * @brief Blocks until everything logged before the call has been written.
+             */
+            void flush();
+
+            /**
+             * @brief Amount of lines dropped because the ring of their thread was full.
+             */
+            uint64_t get_dropped_count() const { return dropped.load(std::memory_order_relaxed); }
+
+        private:
+            struct record {
+                std::chrono::system_clock::time_point time;
+                log_level level;
+                uint8_t tag_length;
+                uint16_t text_length;
+                char tag[MAX_TAG];
+                char text[MAX_LINE];
+            };
+
+            /**
+             * @brief Ring of one producing thread, drained by the flusher thread only.
+             */
+            struct thread_ring {
+                std::array<record, RING_CAPACITY> records;
+                alignas(64) std::atomic<std::size_t> head{0};   /**< Next record to drain, written by the flusher */
+                alignas(64) std::atomic<std::size_t> tail{0};   /**< Next record to fill, written by the owner */
+                std::atomic<bool> retired{false};               /**< Set once the owning thread exits */
+            };
+
+            /**
+             * @brief Fixed buffer the line stream of a thread formats into. Output past the end is discarded.
+             */
+            class line_buffer : public std::streambuf {
+                public:
+                    line_buffer() { reset(); }
+                    void reset() { setp(data, data + MAX_LINE); }
+                    std::string_view view() const { return { pbase(), static_cast<std::size_t>(pptr() - pbase()) }; }
+
+                protected:
+                    int_type overflow(int_type ch) override { return traits_type::not_eof(ch); }
+
+                private:
+                    char data[MAX_LINE];
+            };
+
+            struct thread_state;
+
+            logger();
+
+            thread_state& local();
+            std::shared_ptr<thread_ring> register_ring();
+            bool drain(std::string& out, std::string& err);
+            void run();
+            static void format(const record& line, std::string& out);
+
+        private:
+            std::atomic<log_level> min_level{log_level::info};
+            std::atomic<uint64_t> dropped{0};
+
+            std::mutex mtx;
+            std::condition_variable wake;
+            std::condition_variable drained;
+            std::vector<std::shared_ptr<thread_ring>> rings;
+            uint64_t drain_generation = 0;
+            bool stopping = false;
+
+            std::thread flusher;
+
+            static constexpr std::chrono::milliseconds FLUSH_INTERVAL{20};
+    };
+}
+
+#define LYNKS_LOG(level, tag, expr)                                                         \
+    do {                                                                                    \
+        auto& lynks_log_ = ::lynks::network::logger::instance();                            \
+        if (lynks_log_.enabled(level)) {                                                    \
+            lynks_log_.begin_line() << expr;                                                \
+            lynks_log_.commit_line(level, tag);                                             \
+        }                                                                                   \
+    } while (0)
+
+#ifdef LYNKS_BACKEND_DEBUG
+#define LYNKS_LOG_DEBUG(tag, expr) LYNKS_LOG(::lynks::network::log_level::debug, tag, expr)
+#else
+// the line is still compiled, so what it names counts as used, but never runs
+#define LYNKS_LOG_DEBUG(tag, expr)                                                          \
+    do {                                                                                    \
+        if constexpr (false) LYNKS_LOG(::lynks::network::log_level::debug, tag, expr);      \
+    } while (0)
+#endif
+
+#define LYNKS_LOG_INFO(tag, expr) LYNKS_LOG(::lynks::network::log_level::info, tag, expr)
+#define LYNKS_LOG_WARNING(tag, expr) LYNKS_LOG(::lynks::network::log_level::warning, tag, expr)
+#define LYNKS_LOG_ERROR(tag, expr) LYNKS_LOG(::lynks::network::log_level::error, tag, expr)
+
+#endif
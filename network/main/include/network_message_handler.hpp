@@ -17,6 +17,7 @@ namespace lynks {
         
         /* Forward declaration of the connection class */
         class connection;
+        class request_arena;
 
         /** 
          * @brief Our response handle for when answering requests from clients.
@@ -24,7 +25,10 @@ namespace lynks {
         template <typename T>
         class message_handle {
             public:
-                T data;
+                std::shared_ptr<request_arena> arena{}; /**< Memory `data` is allocated from, declared first so it outlives `data` */
+                T data{};
+                uint32_t sequence = 0;  /**< Position of the request on its connection, used to keep responses in order */
+                std::chrono::steady_clock::time_point received{};  /**< When the request was read, used to measure queueing */
 
             public:
                 friend std::ostream& operator << (std::ostream os, const message_handle& response) {
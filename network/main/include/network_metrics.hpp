@@ -0,0 +1,191 @@
+/**
+ * @author lafftale1999
+ *
+ * @brief Defines the metrics primitives of the backend and lynks::network::metrics_registry, which
+ * renders them in the Prometheus text format for the `/metrics` route.
+ *
+ * Counters and histograms are sharded per thread: recording is a single relaxed atomic add on a
+ * cache line owned by the calling thread, and the shards are only summed when the metrics are
+ * rendered. Components own their metrics and register a source with the registry, which writes
+ * them out on every scrape.
+ */
+
+#ifndef NETWORK_METRICS_HPP_
+#define NETWORK_METRICS_HPP_
+
+#include "network_common.hpp"
+
+#include <array>
+#include <bit>
+#include <functional>
+#include <string_view>
+
+namespace lynks::network {
+
+    static constexpr std::size_t METRICS_SHARDS = 16;
+
+    /**
+     * @brief Shard of the calling thread, handed out round-robin on first use.
+     */
+    inline std::size_t metrics_shard() {
+        static std::atomic<std::size_t> next{0};
+        thread_local std::size_t shard = next.fetch_add(1, std::memory_order_relaxed) % METRICS_SHARDS;
+        return shard;
+    }
+
+    /**
+     * @brief Monotonic counter sharded per thread.
+     */
+    class sharded_counter {
+        public:
+            void add(uint64_t amount = 1) {
+                cells[metrics_shard()].value.fetch_add(amount, std::memory_order_relaxed);
+            }
+
+            uint64_t value() const {
+                uint64_t total = 0;
+                for (const auto& cell : cells) total += cell.value.load(std::memory_order_relaxed);
+                return total;
+            }
+
+        private:
+            struct alignas(64) cell {
+                std::atomic<uint64_t> value{0};
+            };
+
+            std::array<cell, METRICS_SHARDS> cells;
+    };
+
+    /**
+     * @brief Log-linear latency histogram in nanoseconds, sharded per thread.
+     *
+     * Every power of two from ~1 microsecond (2^`MIN_EXPONENT` ns) to ~137 seconds (2^`MAX_EXPONENT` ns)
+     * is split into `SUB_BUCKETS` linear buckets, which keeps the relative error of a bucket below
+     * `1 / SUB_BUCKETS`. Faster and slower values are counted in an underflow and an overflow bucket.
+     */
+    class latency_histogram {
+        public:
+            static constexpr unsigned SUB_BITS = 3;
+            static constexpr std::size_t SUB_BUCKETS = std::size_t(1) << SUB_BITS;
+            static constexpr unsigned MIN_EXPONENT = 10;
+            static constexpr unsigned MAX_EXPONENT = 37;
+            static constexpr std::size_t BUCKETS = SUB_BUCKETS * (MAX_EXPONENT - MIN_EXPONENT) + 2;
+
+            void record(std::chrono::steady_clock::duration elapsed) {
+                auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+                record_ns(ns > 0 ? static_cast<uint64_t>(ns) : 0);
+            }
+
+            void record_ns(uint64_t ns) {
+                auto& target = shards[metrics_shard()];
+                target.buckets[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+                target.sum_ns.fetch_add(ns, std::memory_order_relaxed);
+            }
+
+            /**
+             * @brief Appends the histogram as Prometheus `_bucket`, `_sum` and `_count` samples.
+             *
+             * @param name the metric family, its `# TYPE` line must already be written.
+             * @param labels extra labels such as `route="/login"`, may be empty.
+             */
+            void write(std::string& out, std::string_view name, std::string_view labels) const;
+
+            static constexpr std::size_t bucket_of(uint64_t ns) {
+                if (ns < (uint64_t(1) << MIN_EXPONENT)) return 0;
+                if (ns >= (uint64_t(1) << MAX_EXPONENT)) return BUCKETS - 1;
+
+                unsigned exponent = static_cast<unsigned>(std::bit_width(ns)) - 1;
+                std::size_t sub = static_cast<std::size_t>(ns >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1);
+
+                return 1 + SUB_BUCKETS * (exponent - MIN_EXPONENT) + sub;
+            }
+
+            /**
+             * @brief Smallest value, in nanoseconds, counted by bucket `index`.
+             */
+            static constexpr uint64_t lower_bound(std::size_t index) {
+                if (index == 0) return 0;
+                if (index == BUCKETS - 1) return uint64_t(1) << MAX_EXPONENT;
+
+                unsigned exponent = static_cast<unsigned>((index - 1) / SUB_BUCKETS) + MIN_EXPONENT;
+                uint64_t sub = (index - 1) % SUB_BUCKETS;
+
+                return (SUB_BUCKETS + sub) << (exponent - SUB_BITS);
+            }
+
+        private:
+            struct alignas(64) shard {
+                std::array<std::atomic<uint64_t>, BUCKETS> buckets{};
+                std::atomic<uint64_t> sum_ns{0};
+            };
+
+            std::array<shard, METRICS_SHARDS> shards;
+
+            static_assert(MIN_EXPONENT >= SUB_BITS && MAX_EXPONENT < 64);
+    };
+
+    class metrics_registry;
+
+    /**
+     * @brief Registration of a metrics source. The source is removed when the handle is destroyed,
+     * so it should be the last member of the class it renders.
+     */
+    class metrics_source {
+        public:
+            metrics_source() = default;
+            metrics_source(metrics_registry* registry, uint64_t id) : registry(registry), id(id) {}
+
+            metrics_source(const metrics_source&) = delete;
+            metrics_source& operator=(const metrics_source&) = delete;
+
+            metrics_source(metrics_source&& other) noexcept
+            : registry(std::exchange(other.registry, nullptr)), id(other.id) {}
+
+            metrics_source& operator=(metrics_source&& other) noexcept;
+
+            ~metrics_source();
+
+        private:
+            metrics_registry* registry = nullptr;
+            uint64_t id = 0;
+    };
+
+    /**
+     * @brief Process wide set of metrics sources, rendered in the Prometheus text format.
+     */
+    class metrics_registry {
+        public:
+            using writer = std::function<void(std::string&)>;
+
+            static metrics_registry& instance();
+
+            /**
+             * @brief Registers `write`, called with the output buffer on every scrape.
+             *
+             * @attention `write` runs on the thread serving the scrape and must be thread-safe.
+             */
+            [[nodiscard]] metrics_source add_source(writer write);
+
+            /**
+             * @brief Renders every registered source.
+             */
+            std::string render() const;
+
+            static void write_type(std::string& out, std::string_view name, std::string_view type, std::string_view help);
+            static void write_sample(std::string& out, std::string_view name, std::string_view labels, double value);
+            static void write_sample(std::string& out, std::string_view name, std::string_view labels, uint64_t value);
+
+        private:
+            friend class metrics_source;
+
+            metrics_registry() = default;
+            void remove_source(uint64_t id);
+
+        private:
+            mutable std::mutex mtx;
+            std::vector<std::pair<uint64_t, writer>> sources;
+            uint64_t next_id = 1;
+    };
+}
+
+#endif
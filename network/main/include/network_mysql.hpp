@@ -10,6 +10,8 @@
 
 #include "network_common.hpp"
 #include "network_queue.hpp"
+#include "network_metrics.hpp"
+#include "network_deadline.hpp"
 
 #include <boost/mysql/any_connection.hpp>
 #include <boost/mysql/connection_pool.hpp>
@@ -23,6 +25,26 @@ namespace mysql = boost::mysql;
 
 namespace lynks {
     namespace network {
+        /**
+         * @brief Query timings of every db_connection of the server, exported once no matter how
+         * many shards the server runs. Thread-safe.
+         */
+        class db_metrics {
+            public:
+                db_metrics();
+
+                db_metrics(const db_metrics&) = delete;
+                db_metrics& operator=(const db_metrics&) = delete;
+
+                latency_histogram acquire_latency;      /**< Waiting for a pooled connection */
+                latency_histogram execute_latency;      /**< Preparing and executing a statement */
+
+            private:
+                void write_metrics(std::string& out) const;
+
+                metrics_source metrics;
+        };
+
         /**
          * @brief Abstract connection to a `mysql`-server based on `Boost` functionality.
          */
@@ -30,12 +52,20 @@ namespace lynks {
             public:
                 /**
                  * @brief Creates the db_connection and initializes the connection_pool. This will grow
-                 * with available connections as our server start using it more. The default cap
-                 * is set at 151 available pooled_connections.
+                 * with available connections as our server start using it more, up to `max_connections`.
                  * 
                  * @param context& the context for the server which the connection is needed for.
+                 * @param stats& timings shared with the db_connection of every other shard.
+                 * @param max_connections cap of the pool, 151 by default. A sharded server splits
+                 * its cap between the pools of its shards.
                  */
-                explicit db_connection(asio::io_context& context);
+                db_connection(asio::io_context& context, db_metrics& stats, std::size_t max_connections = 151);
+
+                /**
+                 * @brief Cancels the connection_pool, closing every pooled connection. Queries
+                 * started afterwards fail. Used on shutdown, after in-flight requests are done.
+                 */
+                void shutdown();
 
                 /**
                  * ASYNC
@@ -43,6 +73,9 @@ namespace lynks {
                  * Sends your prepared query to the db. Templated function to be able to accept
                  * any parameter fitting for `mysql::field_view`.
                  * 
+                 * @param deadline deadline of the request the query is sent for. Acquiring a connection,
+                 * preparing and executing are each cancelled after `STEP_TIMEOUT` or at the deadline,
+                 * whichever comes first.
                  * @param sql a statement template for example `"SELECT * WHERE user.id = ?"`
                  * @param params perfect forwarding of parameters fitting for `mysql::field_view`
                  * 
@@ -51,10 +84,10 @@ namespace lynks {
                 */
                 template<class... Params>
                 asio::awaitable<std::optional<mysql::results>> send_query(
-                    std::string_view sql, Params&&... params
+                    request_deadline deadline, std::string_view sql, Params&&... params
                 ) {
                     mysql::field_view arr[] = { mysql::field_view(params)... };
-                    co_return co_await send_query_impl(sql, arr, sizeof...(Params));
+                    co_return co_await send_query_impl(deadline, sql, arr, sizeof...(Params));
                 }
             
             protected:
@@ -66,6 +99,7 @@ namespace lynks {
                  * Low-level implementation of the `send_query()` member function. Accepts the
                  * the high-level wrapper translation from the public function `send_query(..)`
                  * 
+                 * @param deadline deadline of the request the query is sent for.
                  * @param sql a statement template for example `"SELECT * WHERE user.id = ?"`
                  * @param params pointer to the parameters to be bound to the statement
                  * @param params_size sizeof(params)
@@ -74,6 +108,7 @@ namespace lynks {
                  * returned object will be of type `std::nullopt`. 
                  */
                 asio::awaitable<std::optional<mysql::results>> send_query_impl(
+                    request_deadline deadline,
                     std::string_view sql,
                     mysql::field_view const* params,
                     std::size_t params_size
@@ -82,6 +117,9 @@ namespace lynks {
             private:
                 asio::io_context& context;
                 mysql::connection_pool connection_pool;
+                db_metrics& stats;
+
+                static constexpr std::chrono::seconds STEP_TIMEOUT{5};     /**< Limit of acquiring, preparing and executing each */
 
                 /**
                  * @brief
@@ -91,7 +129,7 @@ namespace lynks {
                  * @return An initialized `mysql::pool_params` which is used to properly initialize
                  * the db_connections `connection_pool`.
                  */
-                static mysql::pool_params get_params();
+                static mysql::pool_params get_params(std::size_t max_connections);
                 
                 /**
                  * @brief Used for printing debugging messages for queries to be sent to the database.
@@ -1,8 +1,8 @@
 /**
  * @author lafftale1999
- * 
- * @brief Defines a simple, templated, thread-safe queue used for passing messages 
- * between asynchronous components of the backend.
+ *
+ * @brief Defines a templated, lock-free, bounded multi-producer/multi-consumer queue used for passing
+ * messages between asynchronous components of the backend.
  */
 
 #ifndef NETWORK_QUEUE_HPP_
@@ -10,92 +10,241 @@
 
 #include "network_common.hpp"
 
-using lock = std::lock_guard<std::mutex>;
+#include <new>
+#include <bit>
+#include <cstddef>
 
 namespace lynks {
     namespace network {
 
-        /* 
-        Templated and Thread safe queue with synchronized methods. Method wait() provides a non-blocking wait using condition_variable.
-        */
+        /**
+         * @brief Lock-free bounded MPMC ring buffer.
+         *
+         * Every cell carries a sequence number telling producers and consumers whether the cell is
+         * free to write or ready to read for the current lap, so neither side takes a lock. Items are
+         * moved in and moved out. Consumers can block in `wait()`, which sleeps on an atomic (futex on
+         * Linux) and is only notified by producers when someone is actually waiting.
+         *
+         * @note The capacity is rounded up to the next power of two.
+         */
         template <typename T>
         class queue {
         private:
-            std::deque<T> q;
-            std::mutex mtx;
+            struct cell {
+                std::atomic<std::size_t> sequence;
+                alignas(T) unsigned char storage[sizeof(T)];
+            };
 
-            std::condition_variable cv;
-            std::mutex cv_mutex;
+            static constexpr std::size_t CACHE_LINE = 64;
+
+            std::size_t mask;
+            std::unique_ptr<cell[]> cells;
+
+            alignas(CACHE_LINE) std::atomic<std::size_t> enqueue_pos{0};
+            alignas(CACHE_LINE) std::atomic<std::size_t> dequeue_pos{0};
+            alignas(CACHE_LINE) std::atomic<uint32_t> epoch{0};
+            std::atomic<uint32_t> waiters{0};
+            std::atomic<uint32_t> wakeups{0};
 
         public:
-            queue() = default;
+            /**
+             * @param capacity maximum amount of items held at the same time. Rounded up to a power of two.
+             */
+            explicit queue(std::size_t capacity = 1024)
+            : mask(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1),
+              cells(new cell[mask + 1])
+            {
+                for (std::size_t i = 0; i <= mask; i++) {
+                    cells[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+
             queue(const queue<T>&) = delete;
+            queue<T>& operator=(const queue<T>&) = delete;
 
             virtual ~queue() { clear(); }
 
-            const T& front() {
-                lock l(mtx);
-                return q.front();
+            /**
+             * @brief Moves `item` into the queue.
+             *
+             * @return `false` if the queue is full, the item is then left untouched.
+             */
+            bool push_back(T&& item) {
+                return emplace_back(std::move(item));
             }
 
-            const T& back() {
-                lock l(mtx);
-                return q.back();
+            /**
+             * @brief Copies `item` into the queue.
+             *
+             * @return `false` if the queue is full.
+             */
+            bool push_back(const T& item) {
+                return emplace_back(item);
             }
 
-            void push_back(const T& item) {
-                lock l(mtx);
-                q.push_back(std::move(item));
+            /**
+             * @brief Constructs an item in place at the back of the queue.
+             *
+             * @return `false` if the queue is full.
+             */
+            template <typename... Args>
+            bool emplace_back(Args&&... args) {
+                cell* target;
+                std::size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+
+                for (;;) {
+                    target = &cells[pos & mask];
+                    std::size_t seq = target->sequence.load(std::memory_order_acquire);
+                    auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+
+                    if (diff == 0) {
+                        if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                    } else if (diff < 0) {
+                        return false;
+                    } else {
+                        pos = enqueue_pos.load(std::memory_order_relaxed);
+                    }
+                }
+
+                ::new (static_cast<void*>(target->storage)) T(std::forward<Args>(args)...);
+                target->sequence.store(pos + 1, std::memory_order_release);
 
-                std::unique_lock<std::mutex> ul(cv_mutex);
-                cv.notify_one();
+                notify();
+                return true;
             }
 
-            void emplace_back(const T& item) {
-                lock l(mtx);
-                q.emplace_back(std::move(item));
+            /**
+             * @brief Moves the front item into `out`.
+             *
+             * @return `false` if there was nothing ready to pop.
+             */
+            bool try_pop(T& out) {
+                cell* target;
+                std::size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+
+                for (;;) {
+                    target = &cells[pos & mask];
+                    std::size_t seq = target->sequence.load(std::memory_order_acquire);
+                    auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+
+                    if (diff == 0) {
+                        if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                    } else if (diff < 0) {
+                        return false;
+                    } else {
+                        pos = dequeue_pos.load(std::memory_order_relaxed);
+                    }
+                }
 
-                std::unique_lock<std::mutex> ul(cv_mutex);
-                cv.notify_one();
-            }
+                T* item = std::launder(reinterpret_cast<T*>(target->storage));
+                out = std::move(*item);
+                item->~T();
+                target->sequence.store(pos + mask + 1, std::memory_order_release);
 
-            bool is_empty() {
-                lock l(mtx);
-                return q.empty();
+                return true;
             }
 
-            size_t size() {
-                lock l(mtx);
-                return q.size();
+            /**
+             * @brief Pops the front item if there is one.
+             */
+            std::optional<T> try_pop() {
+                T item;
+                if (try_pop(item)) return item;
+                return std::nullopt;
             }
 
-            void clear() {
-                lock l(mtx);
-                q.clear();
+            /**
+             * @brief Pops up to `max_items` items and writes them to `out`.
+             *
+             * @return amount of items popped.
+             */
+            template <typename OutputIt>
+            std::size_t try_pop_n(OutputIt out, std::size_t max_items) {
+                std::size_t popped = 0;
+                T item;
+
+                while (popped < max_items && try_pop(item)) {
+                    *out++ = std::move(item);
+                    popped++;
+                }
+
+                return popped;
             }
 
+            /**
+             * @brief Pops the front item, blocking in `wait()` until one is available.
+             */
             T pop_front() {
-                lock l(mtx);
-                auto item = std::move(q.front());
-                q.pop_front();
+                T item;
+                while (!try_pop(item)) wait();
                 return item;
             }
 
-            T pop_back() {
-                lock l(mtx);
-                auto item = std::move(q.back());
-                q.pop_back();
-                return item;
+            /**
+             * @brief Checks if the front cell holds a readable item.
+             */
+            bool is_empty() const {
+                std::size_t pos = dequeue_pos.load(std::memory_order_acquire);
+                return cells[pos & mask].sequence.load(std::memory_order_acquire) != pos + 1;
             }
 
+            /**
+             * @brief Approximate amount of items in the queue. Exact when no other thread is
+             * pushing or popping.
+             */
+            size_t size() const {
+                std::size_t tail = dequeue_pos.load(std::memory_order_acquire);
+                std::size_t head = enqueue_pos.load(std::memory_order_acquire);
+                return head > tail ? head - tail : 0;
+            }
+
+            size_t capacity() const {
+                return mask + 1;
+            }
+
+            void clear() {
+                T item;
+                while (try_pop(item)) {}
+            }
+
+            /**
+             * @brief Blocks the calling thread until the queue holds at least one item, or until
+             * `wake_waiters()` is called.
+             */
             void wait() {
-                while(is_empty()) {
-                    std::unique_lock<std::mutex> ul(cv_mutex);
-                    cv.wait(ul);
+                uint32_t woken = wakeups.load(std::memory_order_seq_cst);
+
+                while (is_empty() && wakeups.load(std::memory_order_seq_cst) == woken) {
+                    uint32_t observed = epoch.load(std::memory_order_seq_cst);
+                    if (!is_empty() || wakeups.load(std::memory_order_seq_cst) != woken) return;
+
+                    waiters.fetch_add(1, std::memory_order_seq_cst);
+                    epoch.wait(observed, std::memory_order_seq_cst);
+                    waiters.fetch_sub(1, std::memory_order_relaxed);
                 }
             }
+
+            /**
+             * @brief Releases every thread blocked in `wait()` even though the queue is empty.
+             * Used on shutdown.
+             */
+            void wake_waiters() {
+                wakeups.fetch_add(1, std::memory_order_seq_cst);
+                epoch.fetch_add(1, std::memory_order_seq_cst);
+                epoch.notify_all();
+            }
+
+        private:
+            /**
+             * @brief Bumps `epoch` and wakes sleeping consumers. The futex call is skipped when
+             * no consumer is waiting.
+             */
+            void notify() {
+                epoch.fetch_add(1, std::memory_order_seq_cst);
+                if (waiters.load(std::memory_order_seq_cst) > 0) epoch.notify_all();
+            }
         };
     } // network
 } // lynks
 
-#endif
\ No newline at end of file
+#endif
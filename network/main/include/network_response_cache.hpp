@@ -0,0 +1,147 @@
+/**
+ * @author lafftale1999
+ *
+ * @brief Defines lynks::network::response_cache, a set of fully serialized, immutable HTTP responses
+ * built once at start-up. Connections write them as they are, without building or serializing an
+ * http_response per request, which keeps fixed replies such as rejections and load shedding cheap.
+ * Replies whose body changes per request are rendered from a lynks::network::response_template.
+ */
+
+#ifndef NETWORK_RESPONSE_CACHE_HPP_
+#define NETWORK_RESPONSE_CACHE_HPP_
+
+#include "network_common.hpp"
+#include "network_arena.hpp"
+
+#include <charconv>
+
+namespace lynks::network {
+
+    /**
+     * @brief Shared, immutable wire bytes of a complete HTTP response.
+     */
+    using serialized_response = std::shared_ptr<const std::string>;
+
+    /**
+     * @brief A fixed reply serialized twice, once keeping the connection alive and once closing it.
+     * Both are HTTP/1.1 whatever the version of the request, the keep-alive variant carries an
+     * explicit `Connection: keep-alive` for HTTP/1.0 clients.
+     */
+    struct cached_reply {
+        serialized_response keep_alive;
+        serialized_response close;
+
+        const serialized_response& get(bool keep_alive_connection) const {
+            return keep_alive_connection ? keep_alive : close;
+        }
+
+        /**
+         * @brief Serializes both variants of `response`. The `Connection` header and the payload
+         * are prepared here.
+         */
+        static cached_reply build(http_response response);
+    };
+
+    /**
+     * @brief Pre-serialized head of a response whose body changes per request. Rendering a
+     * response copies the head, the `Content-Length` value and the body into one buffer,
+     * no header field is set or serialized per request.
+     */
+    class response_template {
+        public:
+            /**
+             * @brief Serializes the header of `response` in a keep-alive and a close variant. Its body
+             * and `Content-Length` are ignored.
+             */
+            static response_template build(http_response response);
+
+            /**
+             * @brief Writes the complete wire bytes of the response with `body` into `out`.
+             *
+             * @param keep_alive the variant to use, should follow the request.
+             */
+            void render(arena_string_body::value_type& out, std::string_view body, bool keep_alive) const {
+                const std::string& head = keep_alive ? keep_alive_head : close_head;
+
+                char length[24];
+                auto end = std::to_chars(length, length + sizeof(length), body.size()).ptr;
+
+                out.clear();
+                out.reserve(head.size() + static_cast<std::size_t>(end - length) + 4 + body.size());
+                out.append(head).append(length, end).append("\r\n\r\n").append(body);
+            }
+
+        private:
+            std::string keep_alive_head;    /**< Status line and fields, ending with `Content-Length: ` */
+            std::string close_head;
+    };
+
+    /**
+     * @brief Pre-serialized responses shared by every connection of a server.
+     */
+    class response_cache {
+        public:
+            /**
+             * @param retry_after value of the `Retry-After` header of the `503 Service Unavailable` and
+             * `429 Too Many Requests` replies.
+             */
+            explicit response_cache(std::chrono::seconds retry_after);
+
+            /**
+             * @brief `503 Service Unavailable` with `Retry-After`, sent when a request is shed.
+             */
+            const cached_reply& service_unavailable() const;
+
+            /**
+             * @brief `429 Too Many Requests` with `Retry-After`, sent to clients over their admission limits.
+             */
+            const cached_reply& too_many_requests() const;
+
+            const cached_reply& not_found() const;
+            const cached_reply& bad_request() const;
+            const cached_reply& payload_too_large() const;
+            const cached_reply& expectation_failed() const;
+            const cached_reply& internal_error() const;
+
+            /**
+             * @brief `504 Gateway Timeout`, sent when a request runs past its deadline.
+             */
+            const cached_reply& gateway_timeout() const;
+
+            /**
+             * @brief `200 OK` answered by the `/health` route.
+             */
+            const cached_reply& health() const;
+
+            /**
+             * @brief Head of the `200 OK` JSON responses of the routes.
+             */
+            const response_template& json() const;
+
+            /**
+             * @brief Serializes a complete response into shared wire bytes.
+             *
+             * @param response& the response to serialize. `prepare_payload()` must have been called.
+             */
+            static serialized_response serialize(const http_response& response);
+
+            /**
+             * @brief Builds a plain text response with the default headers of the server.
+             */
+            static http_response make_text(http::status status, std::string body);
+
+        private:
+            cached_reply unavailable;
+            cached_reply throttled;
+            cached_reply missing;
+            cached_reply malformed;
+            cached_reply too_large;
+            cached_reply unmet_expectation;
+            cached_reply failed;
+            cached_reply timed_out;
+            cached_reply healthy;
+            response_template json_ok;
+    };
+}
+
+#endif
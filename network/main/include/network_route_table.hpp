@@ -0,0 +1,181 @@
+/**
+ * @author lafftale1999
+ *
+ * @brief Defines lynks::network::route_table, a table of HTTP routes built at compile time. Routes
+ * are looked up through a perfect hash of their method and path, so dispatch costs one hash and one
+ * string compare no matter how many routes are registered.
+ */
+
+#ifndef NETWORK_ROUTE_TABLE_HPP_
+#define NETWORK_ROUTE_TABLE_HPP_
+
+#include "network_common.hpp"
+#include "network_admission.hpp"
+
+#include <array>
+#include <bit>
+#include <string_view>
+
+namespace lynks::network {
+
+    /**
+     * @brief A single registered endpoint.
+     */
+    template <typename Handler>
+    struct route {
+        http::verb method;
+        std::string_view path;
+        Handler handler;
+        std::uint64_t body_limit;   /**< Largest body accepted, checked before the body is read */
+        rate_limit rate;            /**< Requests per client on this route, unlimited when empty */
+        std::chrono::milliseconds deadline;     /**< Budget from reading the request until its answer, none when 0 */
+    };
+
+    /**
+     * @brief Immutable table of `N` routes.
+     *
+     * Two perfect hashes are searched for when the table is built: one over `(method, path)` finding
+     * the route, and one over the path alone, used to tell a wrong method (`405`) from an unknown
+     * path (`404`). The hash seeds are searched at compile time, a table that cannot be hashed
+     * without collisions fails to compile.
+     */
+    template <typename Handler, std::size_t N>
+    class route_table {
+        public:
+            static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+            /**
+             * @brief Result of `find()`.
+             */
+            struct match {
+                const route<Handler>* found = nullptr;  /**< The route, or `nullptr` if none matched */
+                std::size_t path = npos;                /**< Index of the path, `npos` if the path is unknown */
+            };
+
+            consteval explicit route_table(const std::array<route<Handler>, N>& routes)
+            : routes(routes)
+            {
+                for (std::size_t i = 0; i < N; i++) {
+                    std::size_t known = npos;
+                    for (std::size_t j = 0; j < i; j++) {
+                        if (routes[j].method == routes[i].method && routes[j].path == routes[i].path) {
+                            throw "route registered twice";
+                        }
+                    }
+
+                    for (std::size_t j = 0; j < path_count; j++) {
+                        if (paths[j] == routes[i].path) known = j;
+                    }
+
+                    if (known == npos) {
+                        known = path_count;
+                        paths[path_count++] = routes[i].path;
+                    }
+
+                    path_of_route[i] = known;
+                }
+
+                route_seed = find_seed(route_slots, [this](std::size_t i, uint64_t seed){
+                    return hash(this->routes[i].method, this->routes[i].path, seed);
+                }, N);
+
+                path_seed = find_seed(path_slots, [this](std::size_t i, uint64_t seed){
+                    return hash(http::verb::unknown, paths[i], seed);
+                }, path_count);
+            }
+
+            /**
+             * @brief Looks up the route for `method` and `target`. Any query string is ignored.
+             */
+            constexpr match find(http::verb method, std::string_view target) const {
+                std::string_view path = strip_query(target);
+
+                std::size_t index = route_slots[hash(method, path, route_seed) & MASK];
+                if (index != npos && routes[index].method == method && routes[index].path == path) {
+                    return { &routes[index], path_of_route[index] };
+                }
+
+                std::size_t known = path_slots[hash(http::verb::unknown, path, path_seed) & MASK];
+                if (known != npos && paths[known] == path) return { nullptr, known };
+
+                return {};
+            }
+
+            constexpr const std::array<route<Handler>, N>& get_routes() const { return routes; }
+            constexpr std::size_t get_path_count() const { return path_count; }
+            constexpr std::string_view get_path(std::size_t index) const { return paths[index]; }
+            constexpr std::size_t get_path_index(std::size_t route_index) const { return path_of_route[route_index]; }
+
+            /**
+             * @brief Returns the path part of a request target.
+             */
+            static constexpr std::string_view strip_query(std::string_view target) {
+                return target.substr(0, target.find('?'));
+            }
+
+        private:
+            static constexpr std::size_t SLOTS = std::bit_ceil(std::max<std::size_t>(N * 2, 2));
+            static constexpr std::size_t MASK = SLOTS - 1;
+            static constexpr uint64_t MAX_SEED = 4096;
+
+            /**
+             * @brief FNV-1a over the path, mixed with the method and a seed.
+             */
+            static constexpr uint64_t hash(http::verb method, std::string_view path, uint64_t seed) {
+                uint64_t h = 14695981039346656037ull ^ (seed * 0x9E3779B97F4A7C15ull);
+                for (char c : path) {
+                    h ^= static_cast<unsigned char>(c);
+                    h *= 1099511628211ull;
+                }
+
+                h ^= static_cast<uint64_t>(method);
+                h *= 1099511628211ull;
+
+                return h ^ (h >> 29);
+            }
+
+            /**
+             * @brief Searches for a seed placing `count` keys into distinct slots and fills `slots`.
+             */
+            template <typename Hash>
+            static consteval uint64_t find_seed(std::array<std::size_t, SLOTS>& slots, Hash key_hash, std::size_t count) {
+                for (uint64_t seed = 0; seed < MAX_SEED; seed++) {
+                    slots.fill(npos);
+
+                    bool collided = false;
+                    for (std::size_t i = 0; i < count && !collided; i++) {
+                        auto& slot = slots[key_hash(i, seed) & MASK];
+                        if (slot != npos) collided = true;
+                        else slot = i;
+                    }
+
+                    if (!collided) return seed;
+                }
+
+                throw "no perfect hash found for the route table";
+            }
+
+        private:
+            std::array<route<Handler>, N> routes;
+            std::array<std::string_view, N> paths{};
+            std::array<std::size_t, N> path_of_route{};
+            std::size_t path_count = 0;
+
+            std::array<std::size_t, SLOTS> route_slots{};
+            std::array<std::size_t, SLOTS> path_slots{};
+            uint64_t route_seed = 0;
+            uint64_t path_seed = 0;
+    };
+
+    /**
+     * @brief Builds a `route_table`, deducing the amount of routes.
+     */
+    template <typename Handler, std::size_t N>
+    consteval route_table<Handler, N> make_route_table(const route<Handler> (&routes)[N]) {
+        std::array<route<Handler>, N> out{};
+        for (std::size_t i = 0; i < N; i++) out[i] = routes[i];
+        return route_table<Handler, N>(out);
+    }
+}
+
+#endif
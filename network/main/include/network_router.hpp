@@ -2,125 +2,385 @@
  * @author lafftale1999
  * 
  * @brief Defines the lynks::network::router class, which acts as the central HTTP 
- * request dispatcher for the backend. It inspects the incoming request path and 
- * routes each request to the appropriate handler.
+ * request dispatcher for the backend. It looks up the method and path of each incoming
+ * request in a compile-time route table and routes the request to the appropriate handler.
  */
 
 #ifndef NETWORK_ROUTER_HPP_
 #define NETWORK_ROUTER_HPP_
 
 #include "network_common.hpp"
+#include "network_connection.hpp"
+#include "network_response_cache.hpp"
+#include "network_route_table.hpp"
+#include "network_metrics.hpp"
+#include "network_deadline.hpp"
+#include "network_session_handler.hpp"
 #include "user_service.hpp"
 
 namespace lynks {
     namespace network {
         /* 
-        Class for routing incoming requests.
+        Class for routing incoming requests. Endpoints are registered in `ROUTES`.
         */
         class router {
             public:
-                router(db_connection& db)
-                : _user_service(db) {}
+                class shared_metrics;
 
-                asio::awaitable<http_response> handle_request(const http_request& request) {
-                    return route_request(request);
+                /**
+                 * A sharded server runs one router per shard, each with its own service and database
+                 * connection.
+                 * 
+                 * @param db& database connection of the shard, used by the services.
+                 * @param janus& Janus integration shared by every shard.
+                 * @param sessions& login sessions shared by every shard.
+                 * @param cache& pre-serialized replies used to reject requests in `inspect()`.
+                 * @param stats& route metrics shared by the routers of every shard.
+                 */
+                router(db_connection& db, janus_repository& janus, session_handler& sessions, const response_cache& cache, shared_metrics& stats)
+                : _user_service(db, janus, sessions), cache(cache), method_not_allowed(build_method_not_allowed()),
+                  stats(stats)
+                {}
+
+                /**
+                 * @brief Judges a request header before its body is read. Unknown paths are rejected
+                 * with `404`, methods the path is not registered for with `405`, and known routes
+                 * get their own body limit.
+                 */
+                header_verdict inspect(const server_request& request) const {
+                    auto match = find_route(request);
+
+                    if (match.found) return { nullptr, match.found->body_limit };
+
+                    if (match.path != ROUTES.npos) {
+                        stats.rejected_method.add();
+                        return { &method_not_allowed[match.path], 0 };
+                    }
+
+                    stats.rejected_path.add();
+                    return { &cache.not_found(), 0 };
+                }
+
+                /**
+                 * @brief Route of a request header and the rate limit of the route, used by the
+                 * admission control of the server before `inspect()`.
+                 */
+                static route_limit limit_of(const server_request& request) {
+                    auto match = find_route(request);
+                    if (!match.found) return {};
+
+                    return { static_cast<std::size_t>(match.found - ROUTES.get_routes().data()), match.found->rate };
+                }
+
+                /**
+                 * @brief Serves requests whose route needs no I/O, such as `/metrics`, right away. No
+                 * coroutine frame is created for them, so the caller can skip spawning one as well.
+                 * 
+                 * @return the response, or `std::nullopt` if the request has to go through `handle_request()`.
+                 */
+                std::optional<outgoing_response> try_handle_now(const server_request& request) {
+                    auto match = find_route(request);
+
+                    // requests are inspected by the connection before they get here, this only guards
+                    // callers that skip `inspect()`
+                    if (!match.found) return reply(request, cache.not_found());
+                    if (!match.found->handler.now) return std::nullopt;
+
+                    auto started = std::chrono::steady_clock::now();
+                    auto response = (this->*(match.found->handler.now))(request);
+                    record(*match.found, started, response);
+
+                    return response;
+                }
+
+                /**
+                 * @param received when the request was read, the deadline of the route counts from here.
+                 */
+                asio::awaitable<outgoing_response> handle_request(const server_request& request, std::chrono::steady_clock::time_point received) {
+                    return route_request(request, received);
                 }
             
             private:
-                asio::awaitable<http_response> route_request(const http_request& request) {
-                    auto path = request.target();
-                    
-                    std::cout << "[ROUTER] request received to " << path << std::endl;
-
-                    if (path == "/login") {
-                        co_return co_await login_user(request);
-                    } else if (path == "/create") {
-                        co_return co_await create_meeting(request);
-                    } else if (path == "/list_participants") {
-                        co_return co_await list_participants(request);
-                    } else {
-                        std::cout << "[ROUTER] unexpected path received: " << request.target() << std::endl;
-                    }
+                using async_handler = asio::awaitable<outgoing_response> (router::*)(const server_request&, request_deadline);
+                using immediate_handler = outgoing_response (router::*)(const server_request&);
+
+                /**
+                 * @brief Handler of a route, exactly one of the two is set. Routes that need no I/O use
+                 * `now` and are served by `try_handle_now()` without a coroutine frame.
+                 */
+                struct handler {
+                    async_handler async;
+                    immediate_handler now;
+                };
+
+                /**
+                 * @brief Runs the handler of the route under the deadline of the route. Requests whose
+                 * deadline passed while they waited are answered with `504` without running the handler.
+                 */
+                asio::awaitable<outgoing_response> route_request(const server_request& request, std::chrono::steady_clock::time_point received) {
+                    if (auto response = try_handle_now(request)) co_return std::move(*response);
 
-                    co_return not_found(request);
+                    auto match = find_route(request);
+                    auto deadline = match.found->deadline.count() > 0 ? received + match.found->deadline : NO_DEADLINE;
+
+                    auto started = std::chrono::steady_clock::now();
+                    auto response = has_expired(deadline)
+                        ? timed_out(request)
+                        : co_await (this->*(match.found->handler.async))(request, deadline);
+                    record(*match.found, started, response);
+
+                    co_return response;
+                }
+
+                /**
+                 * @brief Counts the response of `entry` and the time its handler took.
+                 */
+                void record(const route<handler>& entry, std::chrono::steady_clock::time_point started, const outgoing_response& response) {
+                    auto& route = stats.route_stats[static_cast<std::size_t>(&entry - ROUTES.get_routes().data())];
+                    route.latency.record(std::chrono::steady_clock::now() - started);
+                    route.responses[std::clamp(response.status() / 100, 1u, 5u) - 1].add();
+                }
+
+                /**
+                 * @brief Serves every registered metrics source in the Prometheus text format.
+                 * Touches neither the database nor Janus.
+                 */
+                outgoing_response serve_metrics(const server_request& request) {
+                    auto response = start_response(request, http::status::ok, "text/plain; version=0.0.4");
+                    response.body() = metrics_registry::instance().render();
+                    response.prepare_payload();
+
+                    return { { .data = std::move(response) }, nullptr };
+                }
+
+                /**
+                 * @brief Liveness probe, answered with a pre-serialized `200 OK`.
+                 */
+                outgoing_response serve_health(const server_request& request) {
+                    return reply(request, cache.health());
                 }
 
-                asio::awaitable<http_response> login_user(const http_request& request) {
-                    std::cout << request << std::endl;
-                    auto result_string = co_await _user_service.log_in_user(request.body());
+                asio::awaitable<outgoing_response> login_user(const server_request& request, request_deadline deadline) {
+                    LYNKS_LOG_DEBUG("ROUTER", request.method_string() << " " << request.target());
+                    auto result_string = co_await _user_service.log_in_user(request.body(), deadline);
 
-                    if (!result_string) co_return bad_request(request);
+                    if (!result_string) co_return failed_request(request, deadline);
 
                     co_return succesful_request(request, *result_string);
                 }
 
-                asio::awaitable<http_response> create_meeting(const http_request& request) {
+                asio::awaitable<outgoing_response> create_meeting(const server_request& request, request_deadline deadline) {
                     try {
-                        std::cout << request << std::endl;
+                        LYNKS_LOG_DEBUG("ROUTER", request.method_string() << " " << request.target());
                         auto token = request.at(http::field::authorization);
 
-                        auto result_string = co_await _user_service.create_meeting(token);
+                        auto result_string = co_await _user_service.create_meeting(token, deadline);
 
-                        if (!result_string) co_return bad_request(request);
+                        if (!result_string) co_return failed_request(request, deadline);
 
                         co_return succesful_request(request, *result_string);
                     } catch (const std::exception& e) {
-                        std::cerr << "[ROUTER] failed create meeting: " << e.what() << std::endl;
+                        LYNKS_LOG_WARNING("ROUTER", "failed create meeting: " << e.what());
                     }
 
                     co_return bad_request(request);
                 }
 
-                asio::awaitable<http_response> list_participants(const http_request& request) {
+                asio::awaitable<outgoing_response> list_participants(const server_request& request, request_deadline deadline) {
                     try {
                         auto token = request.at(http::field::authorization);
-                        auto result_string = co_await _user_service.list_participants(token, request.body());
-                        if (!result_string) co_return bad_request(request);
+                        auto result_string = co_await _user_service.list_participants(token, request.body(), deadline);
+                        if (!result_string) co_return failed_request(request, deadline);
                         co_return succesful_request(request, *result_string);
                     } catch (const std::exception& e) {
-                        std::cerr << "[ROUTER] list_participants failed: " << e.what() << std::endl;
+                        LYNKS_LOG_WARNING("ROUTER", "list_participants failed: " << e.what());
                     }
 
                     co_return bad_request(request);
                 }
 
-                http_response succesful_request(const http_request& request, const std::string& body) {
-                    http::response<http::string_body> response;
+                /**
+                 * @brief Creates a response allocated from the arena of `request`, with the common
+                 * fields set. The body is left empty.
+                 */
+                static server_response start_response(const server_request& request, http::status status, boost::beast::string_view content_type) {
+                    auto allocator = request.get_allocator();
+
+                    server_response response(std::piecewise_construct, std::make_tuple(allocator), std::make_tuple(allocator));
                     response.version(request.version());
-                    response.result(http::status::ok);
+                    response.result(status);
                     response.set(http::field::server, "My HTTP Server");
-                    response.set(http::field::content_type, "application/json");
-                    response.body() = body;
-                    response.prepare_payload();
+                    response.set(http::field::content_type, content_type);
 
                     return response;
                 }
 
-                http_response not_found(const http_request& request) {
-                    http::response<http::string_body> response;
-                    response.version(request.version());
-                    response.result(http::status::not_found);
-                    response.set(http::field::server, "My HTTP Server");
-                    response.set(http::field::content_type, "text/plain");
-                    response.body() = "404 not found";
-                    response.prepare_payload();
+                /**
+                 * @brief Renders a `200 OK` JSON response from the template of the cache into the arena
+                 * of `request`. Only the body and its length are written per request.
+                 */
+                outgoing_response succesful_request(const server_request& request, std::string_view body) {
+                    auto allocator = request.get_allocator();
+
+                    outgoing_response response{
+                        { .data = server_response(std::piecewise_construct, std::make_tuple(allocator), std::make_tuple(allocator)) },
+                        nullptr,
+                        true
+                    };
+                    cache.json().render(response.message.data.body(), body, request.keep_alive());
 
                     return response;
                 }
 
-                http_response bad_request(const http_request& request) {
-                    http::response<http::string_body> response;
-                    response.version(request.version());
-                    response.result(http::status::bad_request);
-                    response.set(http::field::server, "My HTTP Server");
-                    response.set(http::field::content_type, "text/plain");
-                    response.body() = "400 bad request";
-                    response.prepare_payload();
+                outgoing_response bad_request(const server_request& request) {
+                    return reply(request, cache.bad_request());
+                }
 
-                    return response;
-                } 
+                /**
+                 * @brief Answers a request the service failed, with `504` if it failed because its
+                 * deadline passed and `400` otherwise.
+                 */
+                outgoing_response failed_request(const server_request& request, request_deadline deadline) {
+                    if (has_expired(deadline)) return timed_out(request);
+                    return bad_request(request);
+                }
+
+                outgoing_response timed_out(const server_request& request) {
+                    stats.deadline_exceeded.add();
+                    return reply(request, cache.gateway_timeout());
+                }
+
+                /**
+                 * @brief Answers with a pre-serialized reply. The connection writes it without a copy, unless
+                 * it shares a TLS write with other responses.
+                 */
+                static outgoing_response reply(const server_request& request, const cached_reply& cached) {
+                    return { {}, cached.get(request.keep_alive()) };
+                }
+
+                /**
+                 * @brief Registered endpoints. Adding an endpoint is a single line here. After the body
+                 * limit follow the token bucket of the route per client, `/login` hashes a password and
+                 * queries the database and is kept the tightest, and the deadline of its requests.
+                 */
+                static constexpr auto ROUTES = make_route_table<handler>({
+                    { http::verb::post, "/login",               { &router::login_user, nullptr },          1024, { 5, 20 },   std::chrono::seconds(3)  },
+                    { http::verb::post, "/create",              { &router::create_meeting, nullptr },      1024, { 2, 10 },   std::chrono::seconds(10) },
+                    { http::verb::post, "/list_participants",   { &router::list_participants, nullptr },   4096, { 10, 40 },  std::chrono::seconds(5)  },
+                    { http::verb::get,  "/metrics",             { nullptr, &router::serve_metrics },       0,    {},          {}                       },
+                    { http::verb::get,  "/health",              { nullptr, &router::serve_health },        0,    {},          {}                       },
+                });
+
+                using route_match = decltype(ROUTES)::match;
+
+                static route_match find_route(const server_request& request) {
+                    auto target = request.target();
+                    return ROUTES.find(request.method(), std::string_view(target.data(), target.size()));
+                }
+
+                /**
+                 * @brief Builds one `405 Method Not Allowed` reply per path, listing the methods
+                 * registered for the path in `Allow`.
+                 */
+                static std::vector<cached_reply> build_method_not_allowed() {
+                    std::vector<std::string> allowed(ROUTES.get_path_count());
+
+                    const auto& routes = ROUTES.get_routes();
+                    for (std::size_t i = 0; i < routes.size(); i++) {
+                        auto& allow = allowed[ROUTES.get_path_index(i)];
+                        if (!allow.empty()) allow += ", ";
+                        auto method = http::to_string(routes[i].method);
+                        allow.append(method.data(), method.size());
+                    }
+
+                    std::vector<cached_reply> replies;
+                    replies.reserve(allowed.size());
+
+                    for (const auto& allow : allowed) {
+                        auto response = response_cache::make_text(http::status::method_not_allowed, "405 method not allowed");
+                        response.set(http::field::allow, allow);
+                        replies.push_back(cached_reply::build(std::move(response)));
+                    }
+
+                    return replies;
+                }
             
                 user_service _user_service;
+                const response_cache& cache;
+                const std::vector<cached_reply> method_not_allowed;
+
+                shared_metrics& stats;
+
+            public:
+                /**
+                 * @brief Responses, handler latencies and rejections of every route, exported once
+                 * no matter how many routers the server runs. Thread-safe.
+                 */
+                class shared_metrics {
+                    public:
+                        shared_metrics()
+                        : route_labels(build_route_labels()),
+                          metrics(metrics_registry::instance().add_source([this](std::string& out){ write_metrics(out); }))
+                        {}
+
+                        shared_metrics(const shared_metrics&) = delete;
+                        shared_metrics& operator=(const shared_metrics&) = delete;
+
+                    private:
+                        friend class router;
+
+                        /**
+                         * @brief Builds the `route` and `method` labels of every route.
+                         */
+                        static std::vector<std::string> build_route_labels() {
+                            std::vector<std::string> labels;
+
+                            for (const auto& entry : ROUTES.get_routes()) {
+                                auto method = http::to_string(entry.method);
+                                labels.push_back("route=\"" + std::string(entry.path) + "\",method=\"" +
+                                    std::string(method.data(), method.size()) + "\"");
+                            }
+
+                            return labels;
+                        }
+
+                        void write_metrics(std::string& out) const {
+                            static constexpr std::string_view CLASSES[] = { "1xx", "2xx", "3xx", "4xx", "5xx" };
+
+                            metrics_registry::write_type(out, "lynks_http_responses_total", "counter", "Responses sent by the router, per route and status class.");
+                            for (std::size_t i = 0; i < route_stats.size(); i++) {
+                                for (std::size_t c = 0; c < std::size(CLASSES); c++) {
+                                    metrics_registry::write_sample(out, "lynks_http_responses_total",
+                                        route_labels[i] + ",code=\"" + std::string(CLASSES[c]) + "\"", route_stats[i].responses[c].value());
+                                }
+                            }
+
+                            metrics_registry::write_type(out, "lynks_http_request_duration_seconds", "histogram", "Time spent in the route handler.");
+                            for (std::size_t i = 0; i < route_stats.size(); i++) {
+                                route_stats[i].latency.write(out, "lynks_http_request_duration_seconds", route_labels[i]);
+                            }
+
+                            metrics_registry::write_type(out, "lynks_http_rejected_total", "counter", "Requests rejected from their header alone.");
+                            metrics_registry::write_sample(out, "lynks_http_rejected_total", "reason=\"not_found\"", rejected_path.value());
+                            metrics_registry::write_sample(out, "lynks_http_rejected_total", "reason=\"method_not_allowed\"", rejected_method.value());
+
+                            metrics_registry::write_type(out, "lynks_http_deadline_exceeded_total", "counter", "Requests answered with 504 because their deadline passed.");
+                            metrics_registry::write_sample(out, "lynks_http_deadline_exceeded_total", "", deadline_exceeded.value());
+                        }
+
+                        struct route_metrics {
+                            latency_histogram latency;
+                            std::array<sharded_counter, 5> responses;   /**< Indexed by status class, `1xx` to `5xx` */
+                        };
+
+                        const std::vector<std::string> route_labels;
+                        std::array<route_metrics, ROUTES.get_routes().size()> route_stats;
+                        sharded_counter rejected_path;
+                        sharded_counter rejected_method;
+                        sharded_counter deadline_exceeded;
+
+                        metrics_source metrics;
+                };
         };
     } // network
 } // lynks
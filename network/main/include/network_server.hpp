@@ -2,10 +2,12 @@
  * @author lafftale1999
  * 
  * @brief Defines lynks::network::server_interface, the main entry point for running the backend HTTP server. 
- * It owns the Boost.Asio io_context, TCP acceptor and server thread. Sets up logic for accepting incoming 
- * client connections and manages their lifetime through connection objects. Incoming requests are pulled 
- * from a shared queue and handled asynchronously using coroutines, with each request routed through the router 
- * and its result sent back to the originating client.
+ * It owns the Boost.Asio io_context, TCP acceptor and a pool of worker threads running the context, or in 
+ * thread-per-core mode one of each per shard, with the acceptors sharing the port through SO_REUSEPORT. Sets up 
+ * logic for accepting incoming client connections, each bound to its own strand, and manages their lifetime 
+ * through connection objects. Incoming requests are dispatched directly from the 
+ * connection into a router coroutine on the strand of the client, or optionally pulled from a shared queue 
+ * through update(), with each request routed through the router and its result sent back to the originating client.
  */
 
 #ifndef NETWORK_SERVER_HPP_
@@ -13,19 +15,79 @@
 
 #include "network_common.hpp"
 #include "network_connection.hpp"
+#include "network_connection_registry.hpp"
+#include "network_backlog.hpp"
+#include "network_admission.hpp"
+#include "network_response_cache.hpp"
+#include "network_metrics.hpp"
+#include "network_tls.hpp"
 #include "network_router.hpp"
+#include "network_session_handler.hpp"
+#include "network_shard.hpp"
 #include "user_service.hpp"
 
 namespace lynks {
     namespace network {
+        /**
+         * @brief How parsed requests travel from a connection to the router.
+         */
+        enum class dispatch_mode {
+            direct,     /**< The connection spawns the router coroutine on its own strand */
+            queued      /**< Requests are pushed into `requests` and pulled by `update()` */
+        };
+
+        /**
+         * @brief Tunables for the server and the connections it accepts.
+         */
+        struct server_options {
+            std::size_t         worker_count = 1;               /**< Threads running the shared `context` */
+            std::size_t         shard_count = 0;                /**< Thread-per-core mode with this many shards when > 0, replaces `worker_count` */
+            std::size_t         max_db_connections = 151;       /**< Cap of the MySQL pool, split between the shards */
+            std::size_t         max_sessions = 1000;            /**< Login sessions held at most, shared by every shard */
+            dispatch_mode       mode = dispatch_mode::direct;   /**< How requests travel to the router */
+            connection_options  connection;                     /**< Applied to every accepted connection */
+
+            std::size_t         max_backlog_requests = 1024;        /**< Requests in progress before new ones are shed */
+            std::size_t         max_backlog_bytes = 16 << 20;       /**< Request bytes in progress before new ones are shed */
+            std::chrono::seconds retry_after{1};                    /**< `Retry-After` of the 503 sent to shed requests and the 429 sent to throttled clients */
+            admission_options   admission;                          /**< Connection caps and rate limits per client */
+
+            std::chrono::steady_clock::duration drain_timeout = std::chrono::seconds(30);    /**< Time given to in-flight requests on shutdown */
+            bool handle_signals = true;                                                     /**< Drain on `SIGINT` and `SIGTERM` */
+
+            tls_options         tls;                            /**< Optional TLS listener next to the plain one */
+        };
+
         class server_interface {
-            public:
-                server_interface(uint16_t port) : 
-                    acceptor(context, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), port)),
-                    _db_connection(context), router(_db_connection)
-                {
+            private:
+                struct shard;
 
-                }
+            public:
+                /**
+                 * @brief Constructs the server and binds the acceptor to `port`.
+                 * 
+                 * @param port the port to listen on.
+                 * @param options `options.worker_count` threads run the shared `context`. Every connection
+                 * is bound to its own strand, so handlers for one client never run concurrently.
+                 * `dispatch_mode::direct` routes requests on the connections strand while 
+                 * `dispatch_mode::queued` is kept for compatibility and requires `update()` to be called.
+                 * With `options.shard_count` set the server runs that many shards instead, each with
+                 * its own thread, context, acceptor, router and database pool. Connections never leave
+                 * the shard that accepted them. Queued mode always runs a single shard.
+                 */
+                server_interface(uint16_t port, server_options options = {}) : 
+                    options(normalize(options)),
+                    requests(options.max_backlog_requests),
+                    cached_responses(options.retry_after),
+                    sessions(this->options.max_sessions),
+                    shards(build_shards(port)),
+                    signals(shards.front()->control),
+                    drain_timer(shards.front()->control),
+                    expiry_timer(shards.front()->control),
+                    backlog(options.max_backlog_requests, options.max_backlog_bytes),
+                    admission(options.admission),
+                    metrics(metrics_registry::instance().add_source([this](std::string& out){ write_metrics(out); }))
+                {}
 
                 virtual ~server_interface() {
                     stop();
@@ -33,67 +95,253 @@ namespace lynks {
 
                 bool start() {
                     try {
-                        wait_for_client_connection();
+                        if (options.tls.enabled()) tls = std::make_unique<tls_context>(options.tls);
 
-                        context_thread = std::thread([this](){
-                            context.run();
-                        });
+                        for (auto& shard : shards) {
+                            wait_for_client_connection(*shard->acceptor, nullptr, *shard);
+
+                            if (tls) {
+                                shard->tls_acceptor.emplace(open_listener(shard->control, options.tls.port, is_sharded()));
+                                wait_for_client_connection(*shard->tls_acceptor, tls.get(), *shard);
+                            }
+                        }
+
+                        if (tls) LYNKS_LOG_INFO("SERVER", "TLS listener on port " << options.tls.port);
+
+                        expire_sessions();
+
+                        if (options.handle_signals) {
+                            signals.add(SIGINT);
+                            signals.add(SIGTERM);
+                            signals.async_wait([this](const boost::system::error_code& ec, int signal){
+                                if (ec) return;
+
+                                LYNKS_LOG_INFO("SERVER", "received signal " << signal << ", draining");
+                                drain();
+                            });
+                        }
+
+                        for (auto& shard : shards) {
+                            for (std::size_t i = 0; i < shard->threads; i++) {
+                                worker_threads.emplace_back([&shard = *shard](){
+                                    shard.context.run();
+                                });
+                            }
+                        }
                     } catch (const std::exception& e) {
-                        std::cerr << "[SERVER] Exception: " << e.what() << std::endl;
+                        LYNKS_LOG_ERROR("SERVER", "exception: " << e.what());
                         return false;
                     }
 
-                    std::cout << "[SERVER] started" << std::endl;
+                    if (is_sharded()) LYNKS_LOG_INFO("SERVER", "started with " << shards.size() << " shard(s)");
+                    else LYNKS_LOG_INFO("SERVER", "started with " << options.worker_count << " worker thread(s)");
                     return true;
                 }
 
                 bool stop() {
-                    context.stop();
-                    if (context_thread.joinable()) context_thread.join();
+                    for (auto& shard : shards) shard->context.stop();
+                    for (auto& worker : worker_threads) {
+                        if (worker.joinable()) worker.join();
+                    }
+                    worker_threads.clear();
 
-                    std::cout << "[SERVER] stopped" << std::endl;
+                    LYNKS_LOG_INFO("SERVER", "stopped");
                     return true;
                 }
 
-                // ASYNC
-                void wait_for_client_connection() {
-                    acceptor.async_accept(
-                        [this](std::error_code ec, boost::asio::ip::tcp::socket socket) {
-                            wait_for_client_connection();
+                /**
+                 * @brief Blocks the calling thread until all worker threads have finished.
+                 */
+                void join() {
+                    for (auto& worker : worker_threads) {
+                        if (worker.joinable()) worker.join();
+                    }
+                }
+
+                /**
+                 * @brief Starts a graceful shutdown. Thread-safe and idempotent.
+                 * 
+                 * The acceptors are closed, every connection stops reading and closes once the responses
+                 * its client is waiting for are written, and idle keep-alive connections close right away.
+                 * Once every connection and in-flight request is done the database pools and the Janus
+                 * context are shut down in that order and the worker threads return from `join()`.
+                 * Connections left after `options.drain_timeout` are closed first, and the requests they
+                 * cancel get up to `CLOSE_GRACE` to unwind before the contexts stop.
+                 */
+                void drain() {
+                    asio::post(shards.front()->control, [this](){
+                        begin_drain();
+                    });
+                }
+
+                bool is_draining() const {
+                    return draining.load(std::memory_order_acquire);
+                }
+
+                /**
+                 * @brief `true` once the drain has finished and the contexts have been stopped.
+                 */
+                bool is_stopped() const {
+                    return stopped.load(std::memory_order_acquire);
+                }
+
+                /**
+                 * @brief `true` if the last drain finished before its deadline.
+                 */
+                bool drained_cleanly() const {
+                    return clean_drain.load(std::memory_order_acquire);
+                }
+
+                /**
+                 * ASYNC
+                 * 
+                 * @brief Keeps accepting clients on `listener` of `owner`. Connections accepted on the TLS
+                 * listener are handed `listener_tls` and start with the handshake. Accepted connections
+                 * run on the context of `owner` and are routed by its router.
+                 */
+                void wait_for_client_connection(boost::asio::ip::tcp::acceptor& listener, tls_context* listener_tls, shard& owner) {
+                    listener.async_accept(
+                        owner.connection_executor(),
+                        [this, &listener, listener_tls, &owner](std::error_code ec, boost::asio::ip::tcp::socket socket) {
+                            // the acceptor is closed when draining, the accepted socket closes with it
+                            if (draining.load(std::memory_order_acquire)) return;
+
+                            wait_for_client_connection(listener, listener_tls, owner);
                             
                             if (!ec) {
-                                std::cout << "[SERVER] New connection: " << socket.remote_endpoint() << std::endl;
+                                boost::system::error_code endpoint_ec;
+                                auto address = socket.remote_endpoint(endpoint_ec).address();
+                                if (endpoint_ec) return;
+
+                                LYNKS_LOG_DEBUG("SERVER", "new connection: " << address);
+
+                                auto verdict = admission.try_connect(address);
+                                if (verdict == connect_verdict::rejected) {
+                                    reject_connection(std::move(socket), listener_tls == nullptr);
+                                    return;
+                                }
+
+                                // only a connection that was counted is given back, an untracked one would
+                                // take from whichever connection of the address got counted later
+                                bool counted = verdict == connect_verdict::counted;
+                                auto release = [this, address, counted](){
+                                    if (counted) admission.disconnect(address);
+                                };
 
                                 std::shared_ptr<connection> new_connect = 
-                                    std::make_shared<connection>(context, std::move(socket), requests);
+                                    std::make_shared<connection>(
+                                        std::move(socket),
+                                        connection_hooks{
+                                            [this, &owner](std::shared_ptr<connection> client, message_handle<server_request>& request){
+                                                dispatch_request(owner.router, std::move(client), request);
+                                            },
+                                            [this, &owner, address](const server_request& header){
+                                                if (!admission.try_request(address, lynks::network::router::limit_of(header))) {
+                                                    return header_verdict{ &cached_responses.too_many_requests(), 0 };
+                                                }
+
+                                                return owner.router.inspect(header);
+                                            },
+                                            [this, release](std::shared_ptr<connection> client){
+                                                release();
+                                                remove_client(std::move(client));
+                                            }
+                                        },
+                                        counters,
+                                        cached_responses,
+                                        options.connection,
+                                        listener_tls
+                                    );
 
                                 if (on_client_connect(new_connect)) {
-                                    connected_clients.push_back(std::move(new_connect));
-                                    connected_clients.back()->connect_to_client(id_counter++);
-                                    std::cout << "[" << connected_clients.back()->get_id() << "] has connected succesfully" << std::endl;
+                                    auto id = connected_clients.insert(new_connect);
+                                    if (!id) {
+                                        LYNKS_LOG_WARNING("SERVER", "connection registry full, connection denied");
+                                        release();
+                                        return;
+                                    }
+
+                                    uint32_t uid = *id;
+                                    asio::dispatch(new_connect->get_executor(), [new_connect, uid](){
+                                        new_connect->connect_to_client(uid);
+                                    });
+                                    LYNKS_LOG_DEBUG("SERVER", "[" << uid << "] has connected succesfully");
                                 } else {
-                                    std::cerr << "[SERVER] connection denied" << std::endl;
+                                    LYNKS_LOG_WARNING("SERVER", "connection denied");
+                                    release();
                                 }
                             } else {
-                                std::cerr << "[SERVER] New connection error: " << ec.message() << std::endl;
+                                LYNKS_LOG_WARNING("SERVER", "new connection error: " << ec.message());
                             }
                         });
                 }
 
+                /**
+                 * @brief Compatibility path for `dispatch_mode::queued`. Pulls requests from the shared
+                 * `requests` queue and hands them to `on_request()`. Not needed in direct mode. Queued mode
+                 * runs a single shard, whose router handles every request.
+                 * 
+                 * @param max_requests upper bound of requests handled in this call.
+                 * @param wait if it should block until at least one request is available.
+                 */
                 void update(size_t max_requests = -1, bool wait = false) {
                     size_t request_count = 0;
 
                     if (wait) requests.wait();
 
-                    while (request_count < max_requests && !requests.is_empty()) {
-                        auto request = requests.pop_front();
-
-                        on_request(request.client_connection, request.msg);
+                    owned_message_handle<server_request> request;
+                    while (request_count < max_requests && requests.try_pop(request)) {
+                        on_request(shards.front()->router, request.client_connection, request.msg);
+                        request_count++;
                     }
                 }
 
+                /**
+                 * @brief Context of the first shard, the only one unless the server is sharded.
+                 */
                 asio::io_context& get_context() {
-                    return context;
+                    return shards.front()->context;
+                }
+
+                /**
+                 * @brief `true` in thread-per-core mode.
+                 */
+                bool is_sharded() const {
+                    return options.shard_count > 0;
+                }
+
+                dispatch_mode get_dispatch_mode() const {
+                    return options.mode;
+                }
+
+                /**
+                 * @brief Amount of clients currently connected.
+                 */
+                std::size_t get_active_connections() const {
+                    return connected_clients.live_count();
+                }
+
+                /**
+                 * @brief Registry of all connected clients, used for iterating them from admin 
+                 * and metrics code.
+                 */
+                const connection_registry& get_connected_clients() const {
+                    return connected_clients;
+                }
+
+                /**
+                 * @brief Requests accepted but not yet answered, and the amount of requests shed
+                 * because the backlog was full.
+                 */
+                const request_backlog& get_backlog() const {
+                    return backlog;
+                }
+
+                /**
+                 * @brief Timeout counters shared by every connection.
+                 */
+                const connection_counters& get_connection_counters() const {
+                    return counters;
                 }
 
             protected:
@@ -102,51 +350,391 @@ namespace lynks {
                 }
 
                 virtual void on_client_disconnect(std::shared_ptr<connection> client) {
-                    std::cout << "[SERVER] client disconnected: " << client->get_id() << std::endl;
+                    LYNKS_LOG_DEBUG("SERVER", "client disconnected: " << client->get_id());
                 }
 
-                virtual void on_request(std::shared_ptr<connection> client, message_handle<http_request>& request) {
+                /**
+                 * @brief Routes a request admitted by the backlog through `router`, the router of the shard
+                 * `client` belongs to, and sends the result back to `client`. Gives the backlog room back
+                 * once the request is answered.
+                 */
+                virtual void on_request(lynks::network::router& router, std::shared_ptr<connection> client, message_handle<server_request>& request) {
+                    auto size = request_size(request.data);
+
                     if (client->is_connected()) {
-                        auto _request = request.data;
-                        auto client_keepalive = client;
-                        
-                        asio::co_spawn(
-                            context,
-                            [this, client_keepalive, _request]() -> asio::awaitable<void> {
-                                http_response raw_response = co_await router.handle_request(_request);
-                                message_handle<http_response> response{raw_response};
-                                client_keepalive->send_response(response);
-                                co_return;
-                            },
-                            [client_keepalive](std::exception_ptr ptr){
-                                if (ptr) {
-                                    try {
-                                        std::rethrow_exception(ptr);
-                                    } catch (const std::exception& e) {
-                                        std::cerr << "[SERVER] handled exception: " << e.what() << std::endl;
-                                    }
-                                }
-                            }
-                        );
+                        // routes that need no I/O are answered here, without spawning a coroutine
+                        if (auto response = router.try_handle_now(request.data)) {
+                            request_wait.record(std::chrono::steady_clock::now() - request.received);
+                            backlog.release(size);
+
+                            send_reply(*client, request, std::move(*response));
+                            return;
+                        }
 
+                        // the request is moved along with its arena, the response is built in the same arena. In
+                        // direct mode this is the executor of the client already and the dispatch runs inline
+                        auto executor = client->get_executor();
+                        asio::dispatch(executor, [this, &router, client = std::move(client), size, _request = std::move(request)]() mutable {
+                            spawn_request(router, std::move(client), std::move(_request), size);
+                        });
                     } else {
-                        on_client_disconnect(client);
-                        client.reset();
-                        connected_clients.erase(std::remove(connected_clients.begin(), connected_clients.end(), client), connected_clients.end());
+                        backlog.release(size);
                     }
                 }
             
             private:
-                std::deque<std::shared_ptr<connection>> connected_clients;
-                lynks::network::queue<lynks::network::owned_message_handle<http_request>> requests;
-                boost::asio::io_context context;
-                std::thread context_thread;
-                boost::asio::ip::tcp::acceptor acceptor;
+                /**
+                 * @brief Everything a shard owns. Connections accepted by a shard stay on its context.
+                 */
+                struct shard {
+                    shard(std::size_t threads, db_metrics& db_stats, std::size_t max_db_connections,
+                        janus_repository& janus, session_handler& sessions, const response_cache& cache, lynks::network::router::shared_metrics& route_stats)
+                    : context(static_cast<int>(threads)), control(asio::make_strand(context)),
+                      db(context, db_stats, max_db_connections), router(db, janus, sessions, cache, route_stats),
+                      threads(threads)
+                    {}
+
+                    /**
+                     * @brief Executor for a new connection. A context run by one thread needs no strand.
+                     */
+                    asio::any_io_executor connection_executor() {
+                        if (threads == 1) return context.get_executor();
+                        return asio::make_strand(context);
+                    }
+
+                    boost::asio::io_context context;
+                    asio::strand<asio::io_context::executor_type> control;     /**< Runs the acceptors */
+                    std::optional<boost::asio::ip::tcp::acceptor> acceptor;
+                    std::optional<boost::asio::ip::tcp::acceptor> tls_acceptor;   /**< Set when `options.tls` is enabled */
+                    lynks::network::db_connection db;
+                    lynks::network::router router;
+                    std::size_t threads;
+                };
+
+                static server_options normalize(server_options options) {
+                    options.worker_count = std::max<std::size_t>(options.worker_count, 1);
+                    if (options.mode == dispatch_mode::queued) options.shard_count = 0;
+
+                    return options;
+                }
+
+                /**
+                 * @brief Builds the shards and binds their acceptors. Unsharded, this is one shard run by
+                 * `options.worker_count` threads. Sharded, every shard binds its own acceptor to `port`.
+                 */
+                std::vector<std::unique_ptr<shard>> build_shards(uint16_t port) {
+                    std::size_t count = std::max<std::size_t>(options.shard_count, 1);
+                    std::size_t threads = is_sharded() ? 1 : options.worker_count;
+
+                    std::vector<std::unique_ptr<shard>> built;
+                    built.reserve(count);
+
+                    for (std::size_t i = 0; i < count; i++) {
+                        // the cap of the pool is split between the shards, the remainder goes to the first ones
+                        auto max_db = options.max_db_connections / count + (i < options.max_db_connections % count ? 1 : 0);
+
+                        built.push_back(std::make_unique<shard>(threads, db_stats, max_db, janus, sessions, cached_responses, route_stats));
+                        built.back()->acceptor.emplace(open_listener(built.back()->control, port, is_sharded()));
+                    }
+
+                    return built;
+                }
+
+                /**
+                 * @brief Runs on the control strand of the first shard. Stops accepting and asks every
+                 * connection to drain.
+                 */
+                void begin_drain() {
+                    if (draining.exchange(true, std::memory_order_acq_rel)) return;
+
+                    boost::system::error_code ec;
+                    signals.cancel(ec);
+
+                    // every acceptor is closed on the strand it runs on
+                    for (auto& shard : shards) {
+                        asio::dispatch(shard->control, [&shard = *shard](){
+                            boost::system::error_code ec;
+                            shard.acceptor->close(ec);
+                            if (shard.tls_acceptor) shard.tls_acceptor->close(ec);
+                        });
+                    }
+
+                    for (auto& client : connected_clients.snapshot()) client->drain();
+
+                    drain_deadline = std::chrono::steady_clock::now() + options.drain_timeout;
+                    wait_for_drain();
+                }
+
+                /**
+                 * @brief Removes expired login sessions every `session_handler::EXPIRY_TICK` until the
+                 * contexts are stopped.
+                 */
+                void expire_sessions() {
+                    expiry_timer.expires_after(session_handler::EXPIRY_TICK);
+                    expiry_timer.async_wait([this](const boost::system::error_code& ec){
+                        if (ec) return;
+
+                        sessions.expire_sessions();
+                        expire_sessions();
+                    });
+                }
+
+                /**
+                 * @brief Polls until every connection and in-flight request is done. Once the deadline
+                 * passes, what is left is closed and polled for another `CLOSE_GRACE`, so the requests
+                 * of the closed connections see their cancellation and unwind before the contexts stop.
+                 */
+                void wait_for_drain() {
+                    bool idle = connected_clients.live_count() == 0 && backlog.get_requests() == 0;
+
+                    if (idle) {
+                        finish_drain(!forced_close);
+                        return;
+                    }
+
+                    if (std::chrono::steady_clock::now() >= drain_deadline) {
+                        if (forced_close) {
+                            LYNKS_LOG_WARNING("SERVER", backlog.get_requests() << " request(s) still running after closing, stopping anyway");
+                            finish_drain(false);
+                            return;
+                        }
+
+                        close_remaining();
+                    }
+
+                    drain_timer.expires_after(DRAIN_POLL_INTERVAL);
+                    drain_timer.async_wait([this](const boost::system::error_code& ec){
+                        if (!ec) wait_for_drain();
+                    });
+                }
+
+                /**
+                 * @brief Closes the connections left after the drain deadline, which cancels the work of
+                 * their requests in flight.
+                 */
+                void close_remaining() {
+                    LYNKS_LOG_WARNING("SERVER", "drain deadline passed with " << connected_clients.live_count() <<
+                        " connection(s) and " << backlog.get_requests() << " request(s) left, closing them");
+
+                    for (auto& client : connected_clients.snapshot()) client->disconnect();
+
+                    forced_close = true;
+                    drain_deadline = std::chrono::steady_clock::now() + CLOSE_GRACE;
+                }
+
+                /**
+                 * @brief Shuts down the database pools and the Janus context and stops the context of
+                 * every shard.
+                 */
+                void finish_drain(bool clean) {
+                    for (auto& shard : shards) shard->db.shutdown();
+                    janus.shutdown();
+
+                    boost::system::error_code ec;
+                    expiry_timer.cancel(ec);
+
+                    clean_drain.store(clean, std::memory_order_release);
+                    stopped.store(true, std::memory_order_release);
+
+                    requests.wake_waiters();
+
+                    // queued behind the handlers the pool cancellation posted, so they still run
+                    for (auto& shard : shards) {
+                        asio::post(shard->context, [&context = shard->context](){
+                            context.stop();
+                        });
+                    }
+
+                    LYNKS_LOG_INFO("SERVER", "drained " << (clean ? "cleanly" : "after the deadline"));
+                }
+
+                /**
+                 * @brief Hands the answer of the router to `client`. Responses built in the arena of the
+                 * request keep it alive until they are written, pre-serialized replies let it go.
+                 */
+                static void send_reply(connection& client, const message_handle<server_request>& request, outgoing_response response) {
+                    if (!response.serialized) response.message.arena = request.arena;
+                    response.message.sequence = request.sequence;
+
+                    client.send_response(std::move(response));
+                }
+
+                /**
+                 * @brief Answers a connection over the connection cap of its client with the pre-serialized
+                 * 429 and closes it. TLS connections are closed right away, since nothing can be written to
+                 * them before the handshake.
+                 */
+                void reject_connection(boost::asio::ip::tcp::socket socket, bool plain) {
+                    if (!plain) return;
+
+                    auto rejected = std::make_shared<boost::asio::ip::tcp::socket>(std::move(socket));
+                    const auto& reply = cached_responses.too_many_requests().get(false);
+
+                    // the reply fits in the send buffer of a fresh socket, the write completes right away
+                    asio::async_write(*rejected, asio::buffer(*reply), [rejected, reply](const boost::system::error_code&, std::size_t){
+                        boost::system::error_code ec;
+                        rejected->shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+                    });
+                }
+
+                /**
+                 * @brief Called by the connection when its read loop ends. Removes it from the
+                 * registry so its slot can be reused right away.
+                 */
+                void remove_client(std::shared_ptr<connection> client) {
+                    if (connected_clients.erase(client->get_id())) {
+                        on_client_disconnect(client);
+                    }
+                }
+
+                void write_metrics(std::string& out) const {
+                    metrics_registry::write_type(out, "lynks_active_connections", "gauge", "Connected clients.");
+                    metrics_registry::write_sample(out, "lynks_active_connections", "", static_cast<uint64_t>(connected_clients.live_count()));
+
+                    metrics_registry::write_type(out, "lynks_backlog_requests", "gauge", "Requests accepted but not yet answered.");
+                    metrics_registry::write_sample(out, "lynks_backlog_requests", "", static_cast<uint64_t>(backlog.get_requests()));
+
+                    metrics_registry::write_type(out, "lynks_backlog_bytes", "gauge", "Bytes of the requests accepted but not yet answered.");
+                    metrics_registry::write_sample(out, "lynks_backlog_bytes", "", static_cast<uint64_t>(backlog.get_bytes()));
+
+                    metrics_registry::write_type(out, "lynks_backlog_shed_total", "counter", "Requests answered with 503 because the backlog was full.");
+                    metrics_registry::write_sample(out, "lynks_backlog_shed_total", "", backlog.get_shed_count());
+
+                    metrics_registry::write_type(out, "lynks_request_queue_depth", "gauge", "Requests waiting in the queue of the queued dispatch mode.");
+                    metrics_registry::write_sample(out, "lynks_request_queue_depth", "", static_cast<uint64_t>(requests.size()));
+
+                    metrics_registry::write_type(out, "lynks_request_wait_seconds", "histogram", "Time from reading a request until the router picks it up.");
+                    request_wait.write(out, "lynks_request_wait_seconds", "");
+
+                    metrics_registry::write_type(out, "lynks_connection_timeouts_total", "counter", "Connections closed by a timeout, per phase.");
+                    metrics_registry::write_sample(out, "lynks_connection_timeouts_total", "phase=\"handshake\"", static_cast<uint64_t>(counters.handshake_timeouts.load()));
+                    metrics_registry::write_sample(out, "lynks_connection_timeouts_total", "phase=\"idle\"", static_cast<uint64_t>(counters.idle_timeouts.load()));
+                    metrics_registry::write_sample(out, "lynks_connection_timeouts_total", "phase=\"header\"", static_cast<uint64_t>(counters.header_timeouts.load()));
+                    metrics_registry::write_sample(out, "lynks_connection_timeouts_total", "phase=\"body\"", static_cast<uint64_t>(counters.body_timeouts.load()));
+                    metrics_registry::write_sample(out, "lynks_connection_timeouts_total", "phase=\"write\"", static_cast<uint64_t>(counters.write_timeouts.load()));
+
+                    metrics_registry::write_type(out, "lynks_requests_cancelled_total", "counter", "Requests whose database and Janus work was cancelled because their client went away.");
+                    metrics_registry::write_sample(out, "lynks_requests_cancelled_total", "", static_cast<uint64_t>(counters.cancelled_requests.load()));
+                }
+
+                /**
+                 * @brief Spawns the coroutine routing `request` and bounds it to the cancellation slot of the
+                 * request, so the database and Janus work it waits on is aborted as soon as `client` goes away.
+                 * 
+                 * @attention Must be called on the executor of `client`, which owns the slot.
+                 */
+                void spawn_request(lynks::network::router& router, std::shared_ptr<connection> client, message_handle<server_request> request, std::size_t size) {
+                    if (!client->is_connected()) {
+                        backlog.release(size);
+                        return;
+                    }
+
+                    auto sequence = request.sequence;
+                    auto keep_alive = request.data.keep_alive();
+                    auto slot = client->request_slot(sequence);
+
+                    asio::co_spawn(
+                        client->get_executor(),
+                        [this, &router, client, _request = std::move(request)]() -> asio::awaitable<void> {
+                            request_wait.record(std::chrono::steady_clock::now() - _request.received);
+
+                            auto response = co_await router.handle_request(_request.data, _request.received);
+                            send_reply(*client, _request, std::move(response));
+                            co_return;
+                        },
+                        asio::bind_cancellation_slot(slot, [this, client, sequence, size, keep_alive](std::exception_ptr ptr){
+                            backlog.release(size);
+                            client->request_slot(sequence).clear();
+
+                            // work cancelled because the client went away has nobody left to answer
+                            if (!ptr || !client->is_connected()) return;
+
+                            try {
+                                std::rethrow_exception(ptr);
+                            } catch (const std::exception& e) {
+                                LYNKS_LOG_ERROR("SERVER", "handled exception: " << e.what());
+                            }
+
+                            // every request needs an answer, otherwise the responses after it stay queued
+                            client->send_response(outgoing_response{
+                                message_handle<server_response>{ .sequence = sequence }, cached_responses.internal_error().get(keep_alive)
+                            });
+                        })
+                    );
+                }
+
+                /**
+                 * @brief Approximate size of a request, counted against `options.max_backlog_bytes`.
+                 */
+                static std::size_t request_size(const server_request& request) {
+                    std::size_t size = request.target().size() + request.body().size();
+                    for (const auto& field : request) {
+                        size += field.name_string().size() + field.value().size();
+                    }
+
+                    return size;
+                }
+
+                /**
+                 * @brief Called on the strand of `client` for every parsed request. Requests that do not
+                 * fit in the backlog are answered with the pre-serialized 503 right away. The rest either
+                 * spawn the router coroutine or are pushed into the `requests` queue.
+                 */
+                void dispatch_request(lynks::network::router& router, std::shared_ptr<connection> client, message_handle<server_request>& request) {
+                    auto size = request_size(request.data);
+
+                    if (!backlog.try_acquire(size)) {
+                        client->send_serialized(request.sequence, cached_responses.service_unavailable().get(request.data.keep_alive()));
+                        return;
+                    }
+
+                    if (options.mode == dispatch_mode::direct) {
+                        on_request(router, std::move(client), request);
+                        return;
+                    }
+
+                    auto sequence = request.sequence;
+                    auto keep_alive = request.data.keep_alive();
+
+                    if (!requests.push_back({ client, std::move(request) })) {
+                        backlog.release(size);
+                        client->send_serialized(sequence, cached_responses.service_unavailable().get(keep_alive));
+                    }
+                }
+
+            private:
+                server_options options;
+                connection_registry connected_clients;
+                connection_counters counters;
+                lynks::network::queue<lynks::network::owned_message_handle<server_request>> requests;
+                std::unique_ptr<tls_context> tls;                                   /**< Set when `options.tls` is enabled, shared by every shard */
+                response_cache cached_responses;
+
+                // state shared by every shard, thread-safe or owned per shard
+                db_metrics db_stats;
+                lynks::network::router::shared_metrics route_stats;
+                janus_repository janus;
+                session_handler sessions;
+
+                std::vector<std::unique_ptr<shard>> shards;
+                std::vector<std::thread> worker_threads;
+                asio::signal_set signals;                                           /**< Runs on the control strand of the first shard */
+                asio::steady_timer drain_timer;                                     /**< Runs on the control strand of the first shard */
+                asio::steady_timer expiry_timer;                                    /**< Runs on the control strand of the first shard */
+                std::chrono::steady_clock::time_point drain_deadline;
+                std::atomic<bool> draining{false};
+                std::atomic<bool> stopped{false};
+                std::atomic<bool> clean_drain{false};
+                bool forced_close = false;                                          /**< Set once the drain deadline closed what was left */
+
+                request_backlog backlog;
+                admission_control admission;
+                latency_histogram request_wait;
 
-                lynks::network::db_connection _db_connection;
-                lynks::network::router router;
+                metrics_source metrics;
 
-                uint32_t id_counter = 10000;
+                static constexpr std::chrono::milliseconds DRAIN_POLL_INTERVAL{50};
+                static constexpr std::chrono::seconds CLOSE_GRACE{2};              /**< Wait for cancelled requests after the drain deadline */
         };
     } // network
 } // lynks
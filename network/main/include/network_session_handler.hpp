@@ -2,11 +2,11 @@
  * @author lafftale1999
  * 
  * @brief Defines lynks::network::session_handler, a thread-safe manager for active login 
- * sessions backed by a fixed-size container of session_token objects. It can create new 
+ * sessions backed by hash tables of session_token objects, striped by token hash. It can create new 
  * sessions (issuing a 64-character token), validate tokens (and refresh their lifetime on 
- * use) and look up the associated username for an authenticated request. To keep the 
- * session set clean, it also runs a dedicated cleanup thread that periodically removes 
- * expired/inactive sessions and can be explicitly called via clean_inactive_sessions().
+ * use) and resolve the principal of an authenticated request, both without a lock.
+ * Expired sessions are removed by expire_sessions(), which the server runs every second on its
+ * io_context and which only touches the sessions that are due.
  */
 
 #ifndef NETWORK_SESSION_HANDLER_HPP_
@@ -14,41 +14,41 @@
 
 #include "network_common.hpp"
 #include "network_crypto.hpp"
-#include "network_queue.hpp"
+#include "network_metrics.hpp"
 #include "network_session_token.hpp"
+#include "network_session_table.hpp"
 
 namespace lynks::network {
     
     /**
      * @brief Thread-safe container for handling active sessions.
-     * This will also spawn an extra thread for cleaning up expired sessions.
+     * 
+     * Sessions are split into independently locked session_table stripes, picked by the hash of
+     * their token. Creating and removing sessions locks a single stripe, validating and looking up
+     * a token locks nothing.
      */
     class session_handler {
         public:
             /**
-             * @brief Constructs the session_handler container and spawns
-             * a thread with the `cleanup_task()`.
+             * @brief Constructs the session_handler container.
              * 
-             * @param max_sessions the maximum amount of sessions able to run at the same
-             * time. Set to 1000 by default.
+             * @param capacity the maximum amount of sessions able to run at the same
+             * time. Set to `DEFAULT_CAPACITY` by default.
              */
-            session_handler(uint16_t max_sessions = 1000);
-
-            /**
-             * @brief Destructs the session_handler and joins the cleanup thread
-             */
-            ~session_handler();
+            explicit session_handler(std::size_t capacity = DEFAULT_CAPACITY);
 
             /**
              * @brief Creates and adds a new session_token to the session_handler container.
              * 
-             * @param username this is the username used to identify the user.
+             * @param principal the user logging in, handed back by resolve() for every request
+             * made with the token.
              * 
              * @return Either a string containing a 64-char sized hash-string or
              * std::nullopt if it failed.
              */
-            std::optional<std::string> new_session(std::string username);
-            
+            std::optional<std::string> new_session(session_principal principal);
+
+
             /**
              * @brief Validates the token passed. This will also update the tokens lifetime if it
              * exists and is valid.
@@ -70,45 +70,43 @@ namespace lynks::network {
             std::optional<std::string> get_username_by_token(const std::string& token);
 
             /**
-             * @brief Notifies the `cleanup_thread` to clean the container
-             * from inactive sessions. This will also happen periodically
-             * without explicitly calling this method.
+             * @brief Validates the token, refreshing its lifetime, and fetches the principal captured
+             * at login in a single lookup. Authenticated requests need nothing else.
              * 
-             * For more info about the periodically cleaning see `cleanup_task()`.
+             * @return the principal, or std::nullopt if the token doesn't exist or has expired.
              */
-            void clean_inactive_sessions();
+            std::optional<session_principal> resolve(const std::string& token);
 
-        private:
             /**
-             * @brief Validates the token. Checking if it's active and updates the
-             * life-time.
-             * 
-             * @param token The 64-char hash-string of the token.
+             * @brief Removes the sessions that expired since the last call. Meant to be called every
+             * `EXPIRY_TICK`, new_session() also calls it before giving up on a full container.
              * 
-             * @return `bool`
+             * @return the amount of sessions removed.
              */
-            bool is_active(const std::string& token);
+            std::size_t expire_sessions();
 
             /**
-             * @brief Searches for the token in the sessions container.
-             * 
-             * @param token The 64-char hash-string of the token.
-             * 
-             * @return `true` if the token exists && is_active, `false` if not. 
+             * @brief Sessions held, including ones that expired within the current `EXPIRY_TICK`.
              */
-            bool find_token(const std::string& token);
+            std::size_t size() const;
+
+            static constexpr std::size_t DEFAULT_CAPACITY = 1000;
+            static constexpr std::chrono::seconds EXPIRY_TICK{1};
 
+        private:
             /**
-             * @brief Thread safe cleanup task ran in `cleanup_thread`.
-             * Utilizes the following fields:
-             * 
-             * - `std::atomic<bool> clean` - If it should continue cleaning.
-             * 
-             * - `std::atomic<bool> panic_clean` - If it needs panic_cleaning.
-             * 
-             * - `static constexpr uint16_t CLEANUP_INTERVAL_MS` - Intervals for cleaning.
+             * @brief Calls `operation` with the session of the token, or `nullptr` if the token is
+             * malformed or unknown. Lock-free.
              */
-            void cleanup_task();
+            template <typename Operation>
+            auto with_session(const std::string& token, Operation&& operation) {
+                auto key = parse_token(token);
+                if (!key) return operation(static_cast<session_token*>(nullptr));
+
+                return stripe_of(*key).with_session(*key, std::forward<Operation>(operation));
+            }
+
+            session_table& stripe_of(const token_key& key);
 
             /**
              * @brief Generates a 64-char hash-string suitable as token.
@@ -124,20 +122,21 @@ namespace lynks::network {
              */
             std::string generate_word(size_t word_size);
 
+            void write_metrics(std::string& out) const;
+
         private:
-            std::vector<session_token> sessions;
-            uint16_t max_sessions;
+            std::vector<std::unique_ptr<session_table>> stripes;
+            const std::size_t capacity;
+            std::atomic<std::size_t> held{0};               /**< Sessions over all stripes, bounded by `capacity` */
             
             crypto::random_engine<int64_t> random_int64;
             crypto::random_engine<uint8_t> random_byte;
+            std::mutex random_mtx;                          /**< Guards the random engines */
 
-            std::mutex mtx;
-            std::condition_variable cv;
-            
-            std::thread cleanup_thread;
-            std::atomic<bool> clean{true};
-            std::atomic<bool> panic_clean{false};
-            static constexpr uint16_t CLEANUP_INTERVAL_MS = 30000;  
+            static constexpr std::size_t STRIPE_SESSIONS = 64;     /**< Sessions per stripe the stripe count aims for */
+            static constexpr std::size_t MAX_STRIPES = 64;
+
+            metrics_source metrics;
         };
 }
 
@@ -0,0 +1,145 @@
+/**
+ * @author lafftale1999
+ *
+ * @brief Defines lynks::network::session_table, one stripe of the session store of a session_handler.
+ * It is an open-addressing hash table keyed by the 32 bytes a 64-char hex token decodes to. Lookups
+ * read it without a lock, while adding and expiring sessions lock the stripe and free expired sessions
+ * only after an epoch_domain grace period. Expiry runs off a timing wheel, so it only touches the
+ * sessions that are due.
+ */
+
+#ifndef NETWORK_SESSION_TABLE_HPP_
+#define NETWORK_SESSION_TABLE_HPP_
+
+#include "network_common.hpp"
+#include "network_session_token.hpp"
+#include "network_epoch.hpp"
+
+#include <string_view>
+
+namespace lynks::network {
+
+    /**
+     * @brief Decodes a 64-char hex token.
+     *
+     * @return the key, or std::nullopt if `token` is not 64 hex characters.
+     */
+    std::optional<token_key> parse_token(std::string_view token);
+
+    /**
+     * @brief Hash table of sessions with linear probing, read without locks.
+     *
+     * Slots hold pointers to sessions. Removing a session leaves a tombstone in its slot, so the
+     * probe sequence of every other session stays intact for readers running at the same time. Once
+     * live sessions and tombstones fill three quarters of the slots, the slots are rebuilt into a new
+     * array which replaces the old one for new readers. Tokens are SHA-256 output generated by the
+     * server, so the first 8 bytes of the key are used as its hash as they are.
+     *
+     * Every session also sits in the bucket of a timing wheel of one second per bucket, picked by
+     * when it expires. Refreshing a session only stores its new lifetime. When its bucket comes up,
+     * a session that was refreshed meanwhile moves to the bucket of its new expiry and the rest are
+     * removed. The wheel spans more than a session lifetime, so one lap is enough for any session.
+     */
+    class alignas(64) session_table {
+        public:
+            /**
+             * @param capacity sessions the table holds at most.
+             */
+            explicit session_table(std::size_t capacity);
+
+            ~session_table();
+
+            session_table(const session_table&) = delete;
+            session_table& operator=(const session_table&) = delete;
+
+            /**
+             * @brief Calls `operation` with the session of `key`, or `nullptr` if there is none, and
+             * returns its result. Lock-free. The session must not be used after `operation` returns.
+             */
+            template <typename Operation>
+            auto with_session(const token_key& key, Operation&& operation) {
+                epoch_domain::read_guard guard(epoch);
+                return operation(find(*current.load(std::memory_order_acquire), key));
+            }
+
+            /**
+             * @brief Adds a session of `principal` under `key`.
+             *
+             * @return `false` if the table is full or `key` is already taken.
+             */
+            bool insert(const token_key& key, session_principal principal);
+
+            /**
+             * @brief Runs the timing wheel up to `now_ms`, removing the sessions that expired. Readers
+             * are never blocked, the removed sessions are freed once no reader can hold them anymore.
+             *
+             * @param now_ms current time on the clock of `session_token::get_now_ms()`.
+             *
+             * @return the amount of sessions removed.
+             */
+            std::size_t expire(uint64_t now_ms);
+
+            std::size_t size() const { return count.load(std::memory_order_relaxed); }
+            std::size_t capacity() const { return max_count; }
+
+        private:
+            struct slot_array {
+                explicit slot_array(std::size_t size)
+                : slots(std::make_unique<std::atomic<session_token*>[]>(size)), mask(size - 1) {}
+
+                std::unique_ptr<std::atomic<session_token*>[]> slots;
+                std::size_t mask;
+            };
+
+            /**
+             * @brief Marks a slot whose session was removed. Never dereferenced.
+             */
+            static session_token* tombstone() {
+                return reinterpret_cast<session_token*>(&TOMBSTONE);
+            }
+
+            static bool is_live(const session_token* session) {
+                return session && session != tombstone();
+            }
+
+            static std::size_t home_of(const slot_array& table, const token_key& key);
+
+            static session_token* find(const slot_array& table, const token_key& key);
+
+            /**
+             * @brief Moves the live sessions into a fresh array without tombstones. Must be called with
+             * `mtx` held.
+             */
+            void rebuild();
+
+            /**
+             * @brief Puts `session` into the bucket of its expiry, or of the tick after `current_tick`
+             * if that has passed. Must be called with `mtx` held.
+             */
+            void schedule(session_token* session);
+
+            /**
+             * @brief Replaces the slot of `session` with a tombstone. Must be called with `mtx` held.
+             */
+            void unlink(session_token* session);
+
+        private:
+            std::mutex mtx;                                 /**< Serializes writers, readers never take it */
+            epoch_domain epoch;
+            std::atomic<slot_array*> current;
+            std::atomic<std::size_t> count{0};
+            std::size_t tombstones = 0;
+            const std::size_t max_count;
+
+            std::vector<std::vector<session_token*>> wheel;     /**< Sessions by the second they expire in */
+            uint64_t current_tick;                              /**< Second the wheel processes next */
+
+            static constexpr uint64_t TICK_MS = 1000;
+            static constexpr std::size_t WHEEL_SLOTS = 512;     /**< Power of two spanning more than `session_token::max_life_ms` */
+            static_assert(WHEEL_SLOTS * TICK_MS > session_token::max_life_ms);
+
+            static inline char TOMBSTONE = 0;
+    };
+}
+
+#endif
@@ -2,9 +2,10 @@
  * @author lafftale1999
  * 
  * @brief Defines lynks::network::session_token, an object used to represent and track an individual 
- * authentication sessions. Each token binds a 64-character hash to an owner identifier (such as a 
- * username) and maintains a timestamp-based lifetime. This enables lookups with token to receive 
- * the owners username for example.
+ * authentication sessions. Each token binds the binary form of a 64-character hash to the principal
+ * of the user who logged in and maintains a timestamp-based lifetime. This lets authenticated requests
+ * learn who they were made by from the token alone. The lifetime is atomic, so a session can be
+ * validated and refreshed by many threads at once without a lock.
  */
 
 #ifndef NETWORK_SESSION_TOKEN_HPP_
@@ -12,18 +13,37 @@
 
 #include "network_common.hpp"
 
+#include <array>
+
 namespace lynks::network {
+
+    /**
+     * @brief Binary form of a session token, the 32 bytes of its 64 hex characters.
+     */
+    using token_key = std::array<uint8_t, 32>;
+
+    /**
+     * @brief The user a session belongs to, captured from the database at login.
+     */
+    struct session_principal {
+        int64_t user_id = 0;
+        std::string username;
+    };
+
     /**
      * @brief token used for controlling sessions.
      */
     class session_token {
         public:
             /**
-             * @param owner_identifier is the value that identifies the client owning the token.
+             * @param principal the user owning the token.
              * 
-             * @param token Need to be a 64-char hash to pass validation when created..
+             * @param key the decoded 64-char hash of the token.
              */
-            session_token(std::string owner_identifier, std::string token);
+            session_token(session_principal principal, const token_key& key);
+
+            session_token(const session_token&) = delete;
+            session_token& operator=(const session_token&) = delete;
             
             /**
              * @brief Checks if the token is still valid and updates its current life.
@@ -37,29 +57,36 @@ namespace lynks::network {
              */
             bool is_active() const;
 
-            const std::string& get_owner() const;
-            const std::string& get_token() const;
-
-        private:
             /**
-             * @brief Updates the current `life_ms` to now. This will
-             * inherently extend the token's life-time.
+             * @brief Point in time the token expires unless it is refreshed before, on the clock of
+             * `get_now_ms()`.
              */
-            void update_life();
+            uint64_t expires_at_ms() const;
+
+            const session_principal& get_principal() const;
+            const token_key& get_key() const;
 
             /**
-             * @brief Retrieves now() from `std::chrono` casted as ms since epoch.
+             * @brief Retrieves now() from `std::chrono::steady_clock` casted as ms. The lifetime
+             * is measured on it, so changes to the wall clock do not end or extend sessions.
              * 
-             * @return `ms` since epoch.
+             * @return `ms` since the epoch of the steady clock.
              */
-            uint64_t get_now_ms() const;
+            static uint64_t get_now_ms();
+
+            static constexpr uint64_t max_life_ms = 300'000; 
 
         private:
-            std::string token;
-            std::string owner_identifier;
-            uint64_t life_ms;
+            /**
+             * @brief Updates the current `life_ms` to now. This will
+             * inherently extend the token's life-time.
+             */
+            void update_life();
 
-            static constexpr uint64_t max_life_ms = 300'000; 
+        private:
+            token_key key;
+            const session_principal principal;
+            std::atomic<uint64_t> life_ms;
     };
 }
 
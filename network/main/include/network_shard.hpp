@@ -0,0 +1,44 @@
+/**
+ * @author lafftale1999
+ *
+ * @brief Defines the building blocks of the thread-per-core mode of the server. Every shard owns an
+ * io_context run by a single thread and listens on the shared port through its own acceptor.
+ */
+
+#ifndef NETWORK_SHARD_HPP_
+#define NETWORK_SHARD_HPP_
+
+#include "network_common.hpp"
+
+namespace lynks::network {
+
+    /**
+     * @brief Opens a listener on `port`. With `reuse_port` every shard binds its own listener to the
+     * same port and the kernel spreads incoming connections over them.
+     *
+     * @throws boost::system::system_error if the port cannot be bound.
+     */
+    template <typename Executor>
+    asio::ip::tcp::acceptor open_listener(const Executor& executor, uint16_t port, bool reuse_port) {
+        asio::ip::tcp::endpoint endpoint(asio::ip::tcp::v4(), port);
+        asio::ip::tcp::acceptor listener(executor);
+
+        listener.open(endpoint.protocol());
+        listener.set_option(asio::ip::tcp::acceptor::reuse_address(true));
+
+        if (reuse_port) {
+#ifdef SO_REUSEPORT
+            listener.set_option(asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true));
+#else
+            throw boost::system::system_error(asio::error::operation_not_supported, "SO_REUSEPORT");
+#endif
+        }
+
+        listener.bind(endpoint);
+        listener.listen(asio::socket_base::max_listen_connections);
+
+        return listener;
+    }
+}
+
+#endif
@@ -0,0 +1,90 @@
+/**
+ * @author lafftale1999
+ *
+ * @brief Defines lynks::network::tls_context, the TLS configuration shared by every connection
+ * accepted on the TLS listener of the server. It owns the `asio::ssl::context` with the certificate
+ * and key of the server, the session cache and session tickets used to resume returning clients, and
+ * ALPN, which always negotiates `http/1.1`.
+ */
+
+#ifndef NETWORK_TLS_HPP_
+#define NETWORK_TLS_HPP_
+
+#include "network_common.hpp"
+#include "network_metrics.hpp"
+
+#include <boost/asio/ssl.hpp>
+#include <string>
+
+namespace lynks::network {
+
+    /**
+     * @brief Configuration of the TLS listener. TLS is disabled while `port` is 0.
+     */
+    struct tls_options {
+        uint16_t port = 0;                                  /**< Port of the TLS listener, 0 disables it */
+        std::string certificate_file;                       /**< PEM certificate chain of the server */
+        std::string private_key_file;                       /**< PEM private key of the certificate */
+        long session_cache_size = 20480;                    /**< Sessions kept in the server side cache */
+        std::chrono::seconds session_timeout{7200};         /**< Lifetime of cached sessions and session tickets */
+
+        bool enabled() const { return port != 0; }
+    };
+
+    /**
+     * @brief Server side TLS context shared by all TLS connections.
+     *
+     * Clients resume either through a session ticket (stateless, TLS 1.2 and 1.3) or through the
+     * session cache (TLS 1.2 session ids), both skip the certificate exchange and key agreement
+     * of a full handshake. Only TLS 1.2 and newer are accepted.
+     */
+    class tls_context {
+        public:
+            /**
+             * @brief Loads the certificate and key and configures the context.
+             *
+             * @throws boost::system::system_error if the certificate or key cannot be loaded.
+             */
+            explicit tls_context(const tls_options& options);
+
+            tls_context(const tls_context&) = delete;
+            tls_context& operator=(const tls_context&) = delete;
+
+            asio::ssl::context& get_context() {
+                return context;
+            }
+
+            /**
+             * @brief Counts a finished handshake as full or resumed. Thread-safe.
+             */
+            void handshake_done(SSL* ssl, std::chrono::steady_clock::duration elapsed);
+
+            /**
+             * @brief Counts a failed handshake. Thread-safe.
+             */
+            void handshake_failed() {
+                failed_handshakes.add();
+            }
+
+        private:
+            static int select_protocol(SSL* ssl, const unsigned char** out, unsigned char* out_length,
+                const unsigned char* in, unsigned int in_length, void* arg);
+
+            void write_metrics(std::string& out) const;
+
+        private:
+            asio::ssl::context context;
+
+            sharded_counter full_handshakes;
+            sharded_counter resumed_handshakes;
+            sharded_counter failed_handshakes;
+            latency_histogram handshake_latency;
+
+            metrics_source metrics;
+
+            static constexpr unsigned char ALPN_HTTP_1_1[] = { 8, 'h', 't', 't', 'p', '/', '1', '.', '1' };
+            static constexpr unsigned char SESSION_ID_CONTEXT[] = "lynks";
+    };
+}
+
+#endif
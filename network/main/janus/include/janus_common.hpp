@@ -35,4 +35,6 @@ using http_response = http::response<http::string_body>;
 
 namespace asio = boost::asio;
 
+#include "network_logger.hpp"
+
 #endif
\ No newline at end of file
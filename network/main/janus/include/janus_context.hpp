@@ -15,6 +15,8 @@
 #include "janus_response_buffer.hpp"
 #include "janus_response_message.hpp"
 #include "network_crypto.hpp"
+#include "network_metrics.hpp"
+#include "network_deadline.hpp"
 
 using rnd_device = lynks::network::crypto::random_engine<uint64_t>;
 
@@ -71,10 +73,13 @@ namespace janus {
              * In this case, the method will assume waiting for the response to end up in the `long_poll_buffer` instead.
              * 
              * @param request& finished http_request ready to be sent.
+             * @param deadline deadline of the request the call is made for. Bounds the temporary
+             * connection as well as the wait for a response delivered by long poll.
              * 
              * @return `response_message` if succesful, `std::nullopt` if not.
              */
-            asio::awaitable<std::optional<response_message>> send_request(const http_request& request, const std::string& host, const uint16_t port);
+            asio::awaitable<std::optional<response_message>> send_request(const http_request& request, const std::string& host, const uint16_t port,
+                lynks::network::request_deadline deadline = lynks::network::NO_DEADLINE);
 
             std::string get_path() const;
 
@@ -125,6 +130,10 @@ namespace janus {
              */
             std::string generate_string_id();
 
+            static constexpr std::chrono::seconds LONG_POLL_WAIT{30};  /**< Longest wait for a response delivered by long poll */
+
+            void write_metrics(std::string& out) const;
+
         private:
             using asio_work_guard = asio::executor_work_guard<asio::io_context::executor_type>;
 
@@ -140,6 +149,10 @@ namespace janus {
             boost::beast::flat_buffer   long_flat_buffer;   /**< Used for storing the incoming data on the socket */
             response_buffer             long_poll_buffer;   /**< Response buffer for long poll logic */
             http_response               long_temp_response; /**< Temporary storage for incoming responses */
+
+            lynks::network::latency_histogram request_latency;     /**< Round trip of a request on a temporary connection */
+            lynks::network::latency_histogram long_poll_latency;   /**< Wait from an `ack` until the response arrives by long poll */
+            lynks::network::metrics_source    metrics;             /**< Registration of the histograms, kept last */
     };
 }
 
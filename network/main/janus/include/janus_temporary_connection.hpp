@@ -17,6 +17,7 @@
 #define JANUS_CONNECTION_HPP_
 
 #include "janus_common.hpp"
+#include "network_deadline.hpp"
 
 namespace janus {
 
@@ -39,10 +40,13 @@ namespace janus {
              * @param request& request to be sent.
              * @param host& host ip in string format.
              * @param port port number in 4-byte unsigned integer format
+             * @param deadline deadline of the request the call is made for. Every step is cancelled
+             * after `STEP_TIMEOUT` or at the deadline, whichever comes first.
              * 
              * @return `http_response` if succesful or `std::nullopt` if failed.
              */
-            static asio::awaitable<std::optional<http_response>> send_request(asio::io_context& context, const http_request& request, const std::string& host, const uint16_t port);
+            static asio::awaitable<std::optional<http_response>> send_request(asio::io_context& context, const http_request& request, const std::string& host, const uint16_t port,
+                lynks::network::request_deadline deadline = lynks::network::NO_DEADLINE);
 
         private:
             /**
@@ -68,7 +72,7 @@ namespace janus {
              * 
              * @return `true` if connected, else `false`
              */
-            asio::awaitable<bool> connect_to_server();
+            asio::awaitable<bool> connect_to_server(lynks::network::request_deadline deadline);
 
             /**
              * @brief ASYNC
@@ -79,7 +83,7 @@ namespace janus {
              * 
              * @return `true` if write is succesful, else `false`
              */
-            asio::awaitable<bool> send_request_impl(const http_request& request);
+            asio::awaitable<bool> send_request_impl(const http_request& request, lynks::network::request_deadline deadline);
 
             /**
              * @brief ASYNC
@@ -88,7 +92,9 @@ namespace janus {
              * 
              * @return `http_response` if read was succesful, else `std::nullopt`
              */
-            asio::awaitable<std::optional<http_response>> read_response();
+            asio::awaitable<std::optional<http_response>> read_response(lynks::network::request_deadline deadline);
+
+            static constexpr std::chrono::seconds STEP_TIMEOUT{5};    /**< Limit of resolving, connecting, writing and reading each */
             
         private:
             asio::io_context&           context;    /*< context of the caller*/
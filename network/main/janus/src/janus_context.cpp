@@ -13,7 +13,8 @@ namespace janus {
         long_poll_socket(context), 
         long_poll_buffer(context.get_executor()),
         work_guard(asio::make_work_guard(context)),
-        rnd(0, -1)
+        rnd(0, -1),
+        metrics(lynks::network::metrics_registry::instance().add_source([this](std::string& out){ write_metrics(out); }))
     {
         asio::co_spawn(
             context,
@@ -51,19 +52,19 @@ namespace janus {
     asio::awaitable<void> janus::start() {
         auto connected = co_await connect();
         if (!connected) {
-            std::cerr << "[JANUS] failed to connect" << std::endl;
+            LYNKS_LOG_ERROR("JANUS", "failed to connect");
             stop();
             co_return;
         }
 
         auto inited = co_await init();
         if (!inited) {
-            std::cerr << "[JANUS] failed to init" << std::endl;
+            LYNKS_LOG_ERROR("JANUS", "failed to init");
             stop();
             co_return;
         }
 
-        std::cout << "[JANUS] successfully initialized!" << std::endl;
+        LYNKS_LOG_INFO("JANUS", "successfully initialized");
 
         asio::co_spawn(
             context,
@@ -104,11 +105,17 @@ namespace janus {
      * In this case, the method will assume waiting for the response to end up in the `long_poll_buffer` instead.
      * 
      * @param request& finished http_request ready to be sent.
+     * @param deadline deadline of the request the call is made for.
      * 
      * @return `response_message` if succesful, `std::nullopt` if not.
      */
-    asio::awaitable<std::optional<response_message>> janus::send_request(const http_request& request, const std::string& host, const uint16_t port) {
-        auto result = co_await temporary_connection::send_request(context, request, host, port);
+    asio::awaitable<std::optional<response_message>> janus::send_request(const http_request& request, const std::string& host, const uint16_t port,
+        lynks::network::request_deadline deadline)
+    {
+        auto started = std::chrono::steady_clock::now();
+        auto result = co_await temporary_connection::send_request(context, request, host, port, deadline);
+        request_latency.record(std::chrono::steady_clock::now() - started);
+
         if (!result) co_return std::nullopt;
         response_message msg;
 
@@ -117,7 +124,7 @@ namespace janus {
             msg = std::move(tmp);
 
         } catch (const std::exception& e) {
-            std::cerr << "[JANUS] failed to parse message" << std::endl;
+            LYNKS_LOG_WARNING("JANUS", "failed to parse message");
             co_return std::nullopt;
         }
         
@@ -126,13 +133,31 @@ namespace janus {
          * our request will be sent to the long_poll_buffer instead.
          */
         if (msg.get_event_type() == "ack") {
-            std::cout << "[JANUS] ack receiver" << std::endl;
-            co_return co_await long_poll_buffer.wait_for_transaction(msg.get_transaction());
+            LYNKS_LOG_DEBUG("JANUS", "ack receiver");
+
+            started = std::chrono::steady_clock::now();
+            if (deadline <= started) co_return std::nullopt;
+
+            auto timeout = std::min<std::chrono::steady_clock::duration>(LONG_POLL_WAIT, deadline - started);
+            auto response = co_await long_poll_buffer.wait_for_transaction(msg.get_transaction(), timeout);
+            long_poll_latency.record(std::chrono::steady_clock::now() - started);
+
+            co_return response;
         }
 
         co_return msg;
     }
 
+    void janus::write_metrics(std::string& out) const {
+        using lynks::network::metrics_registry;
+
+        metrics_registry::write_type(out, "lynks_janus_request_seconds", "histogram", "Round trip of a request to Janus.");
+        request_latency.write(out, "lynks_janus_request_seconds", "");
+
+        metrics_registry::write_type(out, "lynks_janus_long_poll_seconds", "histogram", "Wait for a Janus response delivered by long poll after an ack.");
+        long_poll_latency.write(out, "lynks_janus_long_poll_seconds", "");
+    }
+
     std::string janus::get_path() const {
         return "/janus/" + session_path + "/" + videoroom_path;
     }
@@ -157,7 +182,7 @@ namespace janus {
 
         auto response = co_await send_request(*request, host, port);
         if (!response) {
-            std::cerr << "[JANUS] failed to init session" << std::endl;
+            LYNKS_LOG_WARNING("JANUS", "failed to init session");
             co_return false; 
         }
 
@@ -177,7 +202,7 @@ namespace janus {
 
         auto response = co_await send_request(*request, host, port);
         if (!response) {
-            std::cerr << "[JANUS] failed to init videoroom" << std::endl;
+            LYNKS_LOG_WARNING("JANUS", "failed to init videoroom");
             co_return false;
         }
 
@@ -204,13 +229,13 @@ namespace janus {
         asio::ip::tcp::resolver resolver(context);
         auto endpoints = co_await resolver.async_resolve(host, std::to_string(port), token);
         if (ec) {
-            std::cerr << "[JANUS] resolve failed: " << ec.message() << std::endl;
+            LYNKS_LOG_WARNING("JANUS", "resolve failed: " << ec.message());
             co_return false;
         }
 
         auto connected = co_await asio::async_connect(long_poll_socket, endpoints, token);
         if (ec) {
-            std::cerr << "[JANUS] failed to connect: " << ec.message() << std::endl;
+            LYNKS_LOG_WARNING("JANUS", "failed to connect: " << ec.message());
             co_return false;
         }
 
@@ -240,7 +265,7 @@ namespace janus {
      */
     asio::awaitable<void> janus::send_long_poll_request() {
         if (session_path.empty()) {
-            std::cout << "[JANUS] session_path not initialized properly" << std::endl;
+            LYNKS_LOG_WARNING("JANUS", "session_path not initialized properly");
             co_return;
         }
         auto request = request_mapper::get_request(
@@ -262,7 +287,7 @@ namespace janus {
         );
 
         if (ec) {
-            std::cerr << "[JANUS] failed to write long poll request: " << ec.message() << std::endl;
+            LYNKS_LOG_WARNING("JANUS", "failed to write long poll request: " << ec.message());
         }
 
         co_return;
@@ -293,7 +318,7 @@ namespace janus {
             );
 
             if (ec) {
-                std::cerr << "[JANUS] long poll read failed: " << ec.message() << std::endl;
+                LYNKS_LOG_WARNING("JANUS", "long poll read failed: " << ec.message());
                 co_return;
             }
 
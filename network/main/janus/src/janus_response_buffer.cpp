@@ -38,7 +38,7 @@ namespace janus {
         auto [it, inserted] = waiters.emplace(transaction_number, new_waiter);
 
         if (!inserted) {
-            std::cerr << "[JANUS] already waiting for transaction: " << transaction_number << std::endl;
+            LYNKS_LOG_WARNING("JANUS", "already waiting for transaction: " << transaction_number);
             co_return std::nullopt;
         }
         
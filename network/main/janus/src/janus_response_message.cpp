@@ -46,7 +46,7 @@ namespace janus {
 
             return json.dump();
         } catch (const std::exception& e) {
-            std::cerr << "[JANUS] failed to parse message:\n" << *this;
+            LYNKS_LOG_WARNING("JANUS", "failed to parse message: " << *this);
         }
 
         return "null";
@@ -2,16 +2,18 @@
 
 namespace janus {
     
-    asio::awaitable<std::optional<http_response>> temporary_connection::send_request(asio::io_context& context, const http_request& request, const std::string& host, const uint16_t port) {
+    asio::awaitable<std::optional<http_response>> temporary_connection::send_request(asio::io_context& context, const http_request& request, const std::string& host, const uint16_t port,
+        lynks::network::request_deadline deadline)
+    {
         auto connection = temporary_connection(context, host, port);
 
-        auto connected = co_await connection.connect_to_server();
+        auto connected = co_await connection.connect_to_server(deadline);
         if (!connected) co_return std::nullopt;
 
-        auto request_sent = co_await connection.send_request_impl(request); 
+        auto request_sent = co_await connection.send_request_impl(request, deadline); 
         if (!request_sent) co_return std::nullopt;
 
-        auto response = co_await connection.read_response();
+        auto response = co_await connection.read_response(deadline);
         if (!response) co_return std::nullopt;
 
         co_return *response;
@@ -24,37 +26,35 @@ namespace janus {
         socket.close();
     }
 
-    asio::awaitable<bool> temporary_connection::connect_to_server() {
+    asio::awaitable<bool> temporary_connection::connect_to_server(lynks::network::request_deadline deadline) {
 
         // Error handling
         boost::system::error_code ec;
-        auto token = asio::cancel_after(
-            std::chrono::seconds(5),
-            asio::redirect_error(asio::use_awaitable, ec)
-        );
 
         // Resolve endpoint
         asio::ip::tcp::resolver resolver(context);
-        auto endpoints = co_await resolver.async_resolve(host, port, token);
+        auto endpoints = co_await resolver.async_resolve(host, port,
+            asio::cancel_at(lynks::network::step_deadline(deadline, STEP_TIMEOUT), asio::redirect_error(asio::use_awaitable, ec)));
         if (ec) {
-            std::cerr << "[JANUS] resolve failed: " << ec.message() << std::endl;
+            LYNKS_LOG_WARNING("JANUS", "resolve failed: " << ec.message());
             co_return false;
         }
 
         // Connect to server
-        auto result = co_await boost::asio::async_connect(socket, endpoints, token);
+        auto result = co_await boost::asio::async_connect(socket, endpoints,
+            asio::cancel_at(lynks::network::step_deadline(deadline, STEP_TIMEOUT), asio::redirect_error(asio::use_awaitable, ec)));
         if (ec) {
-            std::cerr << "[JANUS] connection failed: " << ec.message() << std::endl;
+            LYNKS_LOG_WARNING("JANUS", "connection failed: " << ec.message());
             co_return false;
         }
 
         co_return true;
     }
 
-    asio::awaitable<bool> temporary_connection::send_request_impl(const http_request& request) {
+    asio::awaitable<bool> temporary_connection::send_request_impl(const http_request& request, lynks::network::request_deadline deadline) {
         boost::system::error_code ec;
-        auto token = asio::cancel_after(
-            std::chrono::seconds(5),
+        auto token = asio::cancel_at(
+            lynks::network::step_deadline(deadline, STEP_TIMEOUT),
             asio::redirect_error(asio::use_awaitable, ec)
         );
         
@@ -62,14 +62,14 @@ namespace janus {
 
         if (!ec) co_return true;
        
-        std::cerr << "[JANUS] write failed: " << ec.message() << std::endl;
+        LYNKS_LOG_WARNING("JANUS", "write failed: " << ec.message());
         co_return false;
     }
 
-    asio::awaitable<std::optional<http_response>> temporary_connection::read_response() {
+    asio::awaitable<std::optional<http_response>> temporary_connection::read_response(lynks::network::request_deadline deadline) {
         boost::system::error_code ec;
-        auto token = asio::cancel_after(
-            std::chrono::seconds(5),
+        auto token = asio::cancel_at(
+            lynks::network::step_deadline(deadline, STEP_TIMEOUT),
             asio::redirect_error(asio::use_awaitable, ec)
         );
 
@@ -78,7 +78,7 @@ namespace janus {
         co_await http::async_read(socket, buffer, response, token);
 
         if (ec) {
-            std::cerr << "[JANUS] read failed: " << ec.message() << std::endl;
+            LYNKS_LOG_WARNING("JANUS", "read failed: " << ec.message());
             co_return std::nullopt;
         }
 
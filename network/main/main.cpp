@@ -1,11 +1,12 @@
 #include "network_lynks.hpp"
+#include "network_logger.hpp"
 #include <cstdlib>
-#include <iostream>
 #include <string>
 
 class lynks_server : public lynks::network::server_interface {
 public:
-    lynks_server(uint16_t port) : lynks::network::server_interface(port) {}
+    lynks_server(uint16_t port, lynks::network::server_options options) 
+    : lynks::network::server_interface(port, options) {}
 
     bool on_client_connect(std::shared_ptr<lynks::network::connection> client) override {
         (void)client;
@@ -24,21 +25,134 @@ static uint16_t parse_port_or_default(const char* s, uint16_t def) {
     }
 }
 
+static std::size_t parse_count_or_default(const char* s, std::size_t def, int max) {
+    if (!s || *s == '\0') return def;
+    try {
+        int c = std::stoi(std::string(s));
+        if (c < 1 || c > max) return def;
+        return static_cast<std::size_t>(c);
+    } catch (...) {
+        return def;
+    }
+}
+
+/**
+ * @brief Like parse_count_or_default(), but also takes `0`, which turns a limit off.
+ */
+static std::size_t parse_limit_or_default(const char* s, std::size_t def, int max) {
+    if (s && std::string(s) == "0") return 0;
+    return parse_count_or_default(s, def, max);
+}
+
+static std::chrono::steady_clock::duration parse_seconds_or_default(const char* s, std::chrono::steady_clock::duration def) {
+    auto def_s = std::chrono::duration_cast<std::chrono::seconds>(def).count();
+    return std::chrono::seconds(parse_count_or_default(s, static_cast<std::size_t>(def_s), 3600));
+}
+
+static bool parse_flag_or_default(const char* s, bool def) {
+    if (!s || *s == '\0') return def;
+
+    std::string value(s);
+    if (value == "1" || value == "true" || value == "on") return true;
+    if (value == "0" || value == "false" || value == "off") return false;
+    return def;
+}
+
+static lynks::network::dispatch_mode parse_dispatch_mode(const char* s) {
+    if (s && std::string(s) == "queued") return lynks::network::dispatch_mode::queued;
+    return lynks::network::dispatch_mode::direct;
+}
+
+static void apply_log_level(const char* s) {
+    if (!s || *s == '\0') return;
+
+    auto level = lynks::network::parse_log_level(s);
+    if (level) lynks::network::logger::instance().set_level(*level);
+}
+
 int main(int argc, char** argv) {
+    apply_log_level(std::getenv("LOG_LEVEL"));
+
     uint16_t port = parse_port_or_default(std::getenv("PORT"), 60000);
 
+    lynks::network::server_options options;
+    options.worker_count = parse_count_or_default(
+        std::getenv("WORKER_THREADS"),
+        std::max(1u, std::thread::hardware_concurrency()),
+        256
+    );
+    options.mode = parse_dispatch_mode(std::getenv("REQUEST_DISPATCH"));
+    // thread-per-core mode, one shard per core when set to the amount of cores
+    options.shard_count = parse_count_or_default(std::getenv("SHARDS"), options.shard_count, 256);
+    options.max_db_connections = parse_count_or_default(
+        std::getenv("MAX_DB_CONNECTIONS"), options.max_db_connections, 4096
+    );
+    options.max_sessions = parse_count_or_default(
+        std::getenv("MAX_SESSIONS"), options.max_sessions, 1 << 24
+    );
+    options.connection.max_pipelined_requests = parse_count_or_default(
+        std::getenv("MAX_PIPELINED_REQUESTS"),
+        options.connection.max_pipelined_requests,
+        1024
+    );
+
+    options.connection.idle_timeout = parse_seconds_or_default(std::getenv("IDLE_TIMEOUT_S"), options.connection.idle_timeout);
+    options.connection.header_timeout = parse_seconds_or_default(std::getenv("HEADER_TIMEOUT_S"), options.connection.header_timeout);
+    options.connection.body_timeout = parse_seconds_or_default(std::getenv("BODY_TIMEOUT_S"), options.connection.body_timeout);
+
+    options.connection.max_write_batch_bytes = parse_count_or_default(
+        std::getenv("MAX_WRITE_BATCH_BYTES"), options.connection.max_write_batch_bytes, 1 << 24
+    );
+    options.connection.tcp_no_delay = parse_flag_or_default(std::getenv("TCP_NODELAY"), options.connection.tcp_no_delay);
+    options.connection.tcp_cork = parse_flag_or_default(std::getenv("TCP_CORK"), options.connection.tcp_cork);
+
+    options.max_backlog_requests = parse_count_or_default(
+        std::getenv("MAX_BACKLOG_REQUESTS"), options.max_backlog_requests, 1 << 20
+    );
+    options.max_backlog_bytes = parse_count_or_default(
+        std::getenv("MAX_BACKLOG_BYTES"), options.max_backlog_bytes, 1 << 30
+    );
+    options.drain_timeout = parse_seconds_or_default(std::getenv("DRAIN_TIMEOUT_S"), options.drain_timeout);
+
+    // behind a proxy every client shares its address, 0 and ROUTE_RATE_LIMITS=off turn the limits off
+    options.admission.max_connections_per_client = parse_limit_or_default(
+        std::getenv("MAX_CONNECTIONS_PER_IP"), options.admission.max_connections_per_client, 1 << 20
+    );
+    options.admission.requests_per_client.per_second = static_cast<double>(parse_limit_or_default(
+        std::getenv("REQUESTS_PER_SECOND_PER_IP"), static_cast<std::size_t>(options.admission.requests_per_client.per_second), 1 << 20
+    ));
+    options.admission.requests_per_client.burst = static_cast<double>(parse_count_or_default(
+        std::getenv("REQUEST_BURST_PER_IP"), static_cast<std::size_t>(options.admission.requests_per_client.burst), 1 << 20
+    ));
+    options.admission.route_limits = parse_flag_or_default(std::getenv("ROUTE_RATE_LIMITS"), options.admission.route_limits);
+
+    options.tls.port = parse_port_or_default(std::getenv("TLS_PORT"), 0);
+    if (const char* certificate = std::getenv("TLS_CERT_FILE")) options.tls.certificate_file = certificate;
+    if (const char* key = std::getenv("TLS_KEY_FILE")) options.tls.private_key_file = key;
+
     if (argc >= 2) {
         port = parse_port_or_default(argv[1], port);
     }
 
-    lynks_server server(port);
+    if (argc >= 3) {
+        options.worker_count = parse_count_or_default(argv[2], options.worker_count, 256);
+    }
+
+    lynks_server server(port, options);
 
     if (!server.start()) {
-        std::cerr << "Unable to start server on port " << port << std::endl;
+        LYNKS_LOG_ERROR("SERVER", "unable to start server on port " << port);
         return 1;
     }
 
-    while (true) {
-        server.update(-1, true);
+    if (options.mode == lynks::network::dispatch_mode::queued) {
+        while (!server.is_stopped()) {
+            server.update(-1, true);
+        }
     }
+
+    server.join();
+
+    // SIGINT/SIGTERM drain the server, a drain that runs into its deadline exits with 2
+    return server.drained_cleanly() ? 0 : 2;
 }
\ No newline at end of file
@@ -7,16 +7,20 @@ namespace lynks::network {
     janus_repository::janus_repository(std::string host, uint16_t port) 
     : _host(std::move(host)), port(std::move(port)), context(_host, port) {}
 
-    asio::awaitable<std::optional<janus::response_message>> janus_repository::get_info() {
+    void janus_repository::shutdown() {
+        context.stop();
+    }
+
+    asio::awaitable<std::optional<janus::response_message>> janus_repository::get_info(request_deadline deadline) {
         auto request = janus::request_mapper::get_request(
             janus::request_type::GET_INFO,
             std::nullopt, _host, "/janus/info"
         );
 
-        co_return co_await context.send_request(*request, _host, port);
+        co_return co_await context.send_request(*request, _host, port, deadline);
     }
 
-    asio::awaitable<std::optional<janus::response_message>> janus_repository::create_video_meeting() {
+    asio::awaitable<std::optional<janus::response_message>> janus_repository::create_video_meeting(request_deadline deadline) {
         janus::messages::video_room::create_room_request msg_request;
 
         auto request = janus::request_mapper::get_request(
@@ -25,11 +29,11 @@ namespace lynks::network {
             _host, context.get_path()
         );
 
-        co_return co_await context.send_request(*request, _host, port);
+        co_return co_await context.send_request(*request, _host, port, deadline);
     }
 
-    asio::awaitable<std::optional<janus::response_message>> janus_repository::list_participants(const std::string& body) {
-        janus::messages::video_room::list_participants_request msg_request(body);
+    asio::awaitable<std::optional<janus::response_message>> janus_repository::list_participants(std::string_view body, request_deadline deadline) {
+        janus::messages::video_room::list_participants_request msg_request{std::string(body)};
 
         auto request = janus::request_mapper::get_request(
             janus::request_type::LIST_MEETING_PARTICIPANTS,
@@ -37,6 +41,6 @@ namespace lynks::network {
             _host, context.get_path()
         );
 
-        co_return co_await context.send_request(*request, _host, port);
+        co_return co_await context.send_request(*request, _host, port, deadline);
     }
 }
@@ -12,6 +12,7 @@
 
 #include "janus_context.hpp"
 #include "network_secrets.hpp"
+#include "network_deadline.hpp"
 
 namespace lynks::network {
     class janus_repository {
@@ -19,9 +20,17 @@ namespace lynks::network {
             janus_repository(std::string host = JANUS_HOST, uint16_t port = JANUS_PORT);
             ~janus_repository() = default;
 
-            asio::awaitable<std::optional<janus::response_message>> get_info();
-            asio::awaitable<std::optional<janus::response_message>> create_video_meeting();
-            asio::awaitable<std::optional<janus::response_message>> list_participants(const std::string& body);
+            /**
+             * The `deadline` of the request the call is made for bounds every step of the call.
+             */
+            asio::awaitable<std::optional<janus::response_message>> get_info(request_deadline deadline = NO_DEADLINE);
+            asio::awaitable<std::optional<janus::response_message>> create_video_meeting(request_deadline deadline);
+            asio::awaitable<std::optional<janus::response_message>> list_participants(std::string_view body, request_deadline deadline);
+
+            /**
+             * @brief Closes the long poll connection and stops the Janus context. Used on shutdown.
+             */
+            void shutdown();
 
         private:
             std::string _host;
@@ -1,4 +1,5 @@
 #include "user_repo.hpp"
+#include "network_logger.hpp"
 
 namespace lynks::network {
     
@@ -12,8 +13,9 @@ namespace lynks::network {
     --------------------------- PUBLIC MEMBER FUNCTIONS --------------------------------------
     */
 
-    asio::awaitable<std::optional<user>> user_repository::find_user_by_id(const uint32_t id) {
+    asio::awaitable<std::optional<user>> user_repository::find_user_by_id(const uint32_t id, request_deadline deadline) {
         auto result = co_await db.send_query(
+            deadline,
             "SELECT * FROM `users` WHERE users.id = ?",
             id
         );
@@ -23,8 +25,9 @@ namespace lynks::network {
         co_return construct_user_from_result(*result);
     }
 
-    asio::awaitable<std::optional<user>> user_repository::find_user_by_username(const std::string& username) {
+    asio::awaitable<std::optional<user>> user_repository::find_user_by_username(const std::string& username, request_deadline deadline) {
         auto result = co_await db.send_query(
+            deadline,
             "SELECT * FROM `users` WHERE users.username = ?",
             username
         );
@@ -53,7 +56,7 @@ namespace lynks::network {
             user temp(id, username, password);
             return temp;
         } catch (const std::exception& e) {
-            std::cerr << e.what();
+            LYNKS_LOG_WARNING("REPOSITORY", "invalid user row: " << e.what());
             return std::nullopt;
         }
     }
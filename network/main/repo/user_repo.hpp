@@ -17,8 +17,11 @@ namespace lynks::network {
     class user_repository {
         public:
             user_repository(db_connection& _db);
-            asio::awaitable<std::optional<user>> find_user_by_id(const uint32_t id);
-            asio::awaitable<std::optional<user>> find_user_by_username(const std::string& username);
+            /**
+             * The `deadline` of the request the lookup is made for bounds the query.
+             */
+            asio::awaitable<std::optional<user>> find_user_by_id(const uint32_t id, request_deadline deadline);
+            asio::awaitable<std::optional<user>> find_user_by_username(const std::string& username, request_deadline deadline);
 
         private:
             std::optional<user> construct_user_from_result(const mysql::results& result);
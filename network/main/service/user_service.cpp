@@ -1,14 +1,15 @@
 #include "user_service.hpp"
 #include "janus_messages.hpp"
+#include "network_logger.hpp"
 
 namespace lynks::network {
-    user_service::user_service(db_connection& db) 
-    : user_repo(db){}
+    user_service::user_service(db_connection& db, janus_repository& janus, session_handler& sessions) 
+    : user_repo(db), janus_repo(janus), sessions(sessions) {}
 
-    awaitable_opt_str user_service::log_in_user(const std::string& request_body_json) {
-        user temp(request_body_json);
+    awaitable_opt_str user_service::log_in_user(std::string_view request_body_json, request_deadline deadline) {
+        user temp{std::string(request_body_json)};
 
-        auto result = co_await user_repo.find_user_by_username(temp.get_username());
+        auto result = co_await user_repo.find_user_by_username(temp.get_username(), deadline);
         if (!result) co_return std::nullopt;
 
         auto& fetched_user = *result;
@@ -16,7 +17,7 @@ namespace lynks::network {
             co_return std::nullopt;
         }
 
-        auto token = sessions.new_session(fetched_user.get_username());
+        auto token = sessions.new_session({ fetched_user.get_id(), fetched_user.get_username() });
         if (!token) {
             co_return std::nullopt;
         }
@@ -29,17 +30,13 @@ namespace lynks::network {
         co_return json;
     }
 
-    awaitable_opt_str user_service::create_meeting(const std::string& token) {
-        if (sessions.validate_session(token)) {
-            auto username = sessions.get_username_by_token(token);
-            if (!username) co_return std::nullopt;
-
-            auto opt_user = co_await user_repo.find_user_by_username(*username);
-            if (!opt_user) co_return std::nullopt;
-
-            auto janus_response = co_await janus_repo.create_video_meeting();
+    awaitable_opt_str user_service::create_meeting(const std::string& token, request_deadline deadline) {
+        // the principal was read from the database at login, the user needs no lookup here
+        auto principal = sessions.resolve(token);
+        if (principal) {
+            auto janus_response = co_await janus_repo.create_video_meeting(deadline);
             if (!janus_response) {
-                std::cerr << "[SERVICE] failed get information from janus" << std::endl;
+                LYNKS_LOG_WARNING("SERVICE", "failed get information from janus");
                 co_return std::nullopt;
             }
 
@@ -48,21 +45,16 @@ namespace lynks::network {
             co_return msg_response.to_json();
         }
         
-        std::cerr << "[SERVICE] WARNING: Sessions invalid" << std::endl;
+        LYNKS_LOG_WARNING("SERVICE", "sessions invalid");
         co_return std::nullopt;
     }
 
-    awaitable_opt_str user_service::list_participants(const std::string& token, const std::string& body) {
-        if (sessions.validate_session(token)) {
-            auto username = sessions.get_username_by_token(token);
-            if (!username) co_return std::nullopt;
-
-            auto opt_user = co_await user_repo.find_user_by_username(*username);
-            if (!opt_user) co_return std::nullopt;
-
-            auto janus_response = co_await janus_repo.list_participants(body);
+    awaitable_opt_str user_service::list_participants(const std::string& token, std::string_view body, request_deadline deadline) {
+        auto principal = sessions.resolve(token);
+        if (principal) {
+            auto janus_response = co_await janus_repo.list_participants(body, deadline);
             if (!janus_response) {
-                std::cerr << "[SERVICE] failed to get information from janus" << std::endl;
+                LYNKS_LOG_WARNING("SERVICE", "failed to get information from janus");
                 co_return std::nullopt;
             }
 
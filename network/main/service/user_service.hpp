@@ -19,17 +19,26 @@ using awaitable_opt_str = asio::awaitable<std::optional<std::string>>;
 namespace lynks::network {
     class user_service {
         public:
-            user_service(db_connection& db);
+            /**
+             * @param db& database connection of the shard the service runs on.
+             * @param janus& Janus integration shared by every shard.
+             * @param sessions& login sessions shared by every shard.
+             */
+            user_service(db_connection& db, janus_repository& janus, session_handler& sessions);
 
-            awaitable_opt_str log_in_user(const std::string& request_body_json);
-            awaitable_opt_str create_meeting(const std::string& token);
-            awaitable_opt_str list_participants(const std::string& token, const std::string& body);
+            /**
+             * Every call is bounded by `deadline`, the deadline of the request it serves, and returns
+             * `std::nullopt` once it has passed.
+             */
+            awaitable_opt_str log_in_user(std::string_view request_body_json, request_deadline deadline);
+            awaitable_opt_str create_meeting(const std::string& token, request_deadline deadline);
+            awaitable_opt_str list_participants(const std::string& token, std::string_view body, request_deadline deadline);
             
         private:
             user_repository user_repo;
-            janus_repository janus_repo;
+            janus_repository& janus_repo;
             
-            session_handler sessions;
+            session_handler& sessions;
     };
 }
 
@@ -0,0 +1,161 @@
+#include "network_admission.hpp"
+
+#include <bit>
+
+namespace lynks::network {
+
+    /*
+    --------------------------- CONSTRUCTORS --------------------------------------
+    */
+    admission_control::admission_control(const admission_options& options)
+    : options(options),
+      idle_eviction_ns(std::chrono::duration_cast<std::chrono::nanoseconds>(options.idle_eviction).count()),
+      sets(std::make_unique<entry_set[]>(std::bit_ceil(std::max<std::size_t>(options.tracked_entries / WAYS, 1)))),
+      set_mask(std::bit_ceil(std::max<std::size_t>(options.tracked_entries / WAYS, 1)) - 1),
+      metrics(metrics_registry::instance().add_source([this](std::string& out){ write_metrics(out); }))
+    {}
+
+    /*
+    --------------------------- PUBLIC MEMBER FUNCTIONS --------------------------------------
+    */
+    connect_verdict admission_control::try_connect(const asio::ip::address& client) {
+        if (options.max_connections_per_client == 0) return connect_verdict::untracked;
+
+        auto id = make_key(client, CLIENT_SCOPE);
+        auto& set = set_of(id);
+        auto now = now_ns();
+
+        set_lock lock(set);
+
+        auto* slot = find(set, id, now, options.requests_per_client, true);
+        if (!slot) return connect_verdict::untracked;
+
+        if (slot->connections >= options.max_connections_per_client) {
+            rejected_connections.add();
+            return connect_verdict::rejected;
+        }
+
+        slot->connections++;
+        return connect_verdict::counted;
+    }
+
+    void admission_control::disconnect(const asio::ip::address& client) {
+        if (options.max_connections_per_client == 0) return;
+
+        auto id = make_key(client, CLIENT_SCOPE);
+        auto& set = set_of(id);
+
+        set_lock lock(set);
+
+        auto* slot = find(set, id, now_ns(), options.requests_per_client, false);
+        if (slot && slot->connections > 0) slot->connections--;
+    }
+
+    bool admission_control::try_request(const asio::ip::address& client, const route_limit& route) {
+        auto now = now_ns();
+
+        if (!take_token(make_key(client, CLIENT_SCOPE), options.requests_per_client, now)) {
+            rejected_client_rate.add();
+            return false;
+        }
+
+        if (route.route == route_limit::NO_ROUTE || !options.route_limits) return true;
+
+        if (!take_token(make_key(client, static_cast<uint32_t>(route.route) + 1), route.rate, now)) {
+            rejected_route_rate.add();
+            return false;
+        }
+
+        return true;
+    }
+
+    /*
+    --------------------------- PRIVATE MEMBER FUNCTIONS --------------------------------------
+    */
+    admission_control::key admission_control::make_key(const asio::ip::address& client, uint32_t scope) {
+        key id;
+        id.scope = scope;
+
+        if (client.is_v4() || (client.is_v6() && client.to_v6().is_v4_mapped())) {
+            auto v4 = client.is_v4() ? client.to_v4() : asio::ip::make_address_v4(asio::ip::v4_mapped, client.to_v6());
+            id.low = 0xFFFF00000000ull | v4.to_uint();
+            return id;
+        }
+
+        // the /64 prefix, the interface identifier is picked freely by the host
+        auto bytes = client.to_v6().to_bytes();
+        for (std::size_t i = 0; i < 8; i++) id.high = (id.high << 8) | bytes[i];
+
+        return id;
+    }
+
+    admission_control::entry_set& admission_control::set_of(const key& id) {
+        uint64_t h = id.high * 0x9E3779B97F4A7C15ull ^ std::rotl(id.low, 29) ^ (static_cast<uint64_t>(id.scope) * 0xC2B2AE3D27D4EB4Full);
+        h ^= h >> 32;
+        h *= 0xD6E8FEB86659FD93ull;
+        h ^= h >> 32;
+
+        return sets[h & set_mask];
+    }
+
+    admission_control::entry* admission_control::find(entry_set& set, const key& id, int64_t now, const rate_limit& limit, bool claim) {
+        entry* victim = nullptr;
+
+        for (auto& slot : set.entries) {
+            if (slot.used && slot.id == id) return &slot;
+            if (!claim) continue;
+
+            // free first, then idle, then the least recently used one without connections
+            bool free = !slot.used || (slot.connections == 0 && now - slot.last >= idle_eviction_ns);
+            if (free) {
+                if (!victim || victim->used) victim = &slot;
+            } else if (slot.connections == 0 && (!victim || (victim->used && slot.last < victim->last))) {
+                victim = &slot;
+            }
+        }
+
+        if (!claim) return nullptr;
+
+        if (!victim) {
+            untracked.add();
+            return nullptr;
+        }
+
+        *victim = entry{ id, true, 0, static_cast<float>(limit.burst), now };
+        return victim;
+    }
+
+    void admission_control::refill(entry& slot, const rate_limit& limit, int64_t now) {
+        if (now <= slot.last) return;
+
+        double refilled = slot.tokens + static_cast<double>(now - slot.last) * 1e-9 * limit.per_second;
+        slot.tokens = static_cast<float>(std::min(refilled, limit.burst));
+        slot.last = now;
+    }
+
+    bool admission_control::take_token(const key& id, const rate_limit& limit, int64_t now) {
+        if (!limit.limited()) return true;
+
+        auto& set = set_of(id);
+        set_lock lock(set);
+
+        auto* slot = find(set, id, now, limit, true);
+        if (!slot) return true;
+
+        refill(*slot, limit, now);
+        if (slot->tokens < 1.0f) return false;
+
+        slot->tokens -= 1.0f;
+        return true;
+    }
+
+    void admission_control::write_metrics(std::string& out) const {
+        metrics_registry::write_type(out, "lynks_admission_rejected_total", "counter", "Connections and requests answered with 429, per limit.");
+        metrics_registry::write_sample(out, "lynks_admission_rejected_total", "limit=\"connections\"", rejected_connections.value());
+        metrics_registry::write_sample(out, "lynks_admission_rejected_total", "limit=\"client_rate\"", rejected_client_rate.value());
+        metrics_registry::write_sample(out, "lynks_admission_rejected_total", "limit=\"route_rate\"", rejected_route_rate.value());
+
+        metrics_registry::write_type(out, "lynks_admission_untracked_total", "counter", "Clients admitted without limits because their set of the table was full.");
+        metrics_registry::write_sample(out, "lynks_admission_untracked_total", "", untracked.value());
+    }
+}
@@ -0,0 +1,112 @@
+#include "network_connection_registry.hpp"
+
+namespace lynks::network {
+
+    /*
+    --------------------------- CONSTRUCTORS --------------------------------------
+    */
+    connection_registry::connection_registry(std::size_t initial_capacity) {
+        slots.reserve(std::min(initial_capacity, MAX_SLOTS));
+        free_slots.reserve(std::min(initial_capacity, MAX_SLOTS));
+    }
+
+    /*
+    --------------------------- PUBLIC MEMBER FUNCTIONS --------------------------------------
+    */
+    std::optional<uint32_t> connection_registry::insert(std::shared_ptr<connection> client) {
+        std::scoped_lock<std::mutex> lock(mtx);
+
+        uint32_t index;
+        if (!free_slots.empty()) {
+            index = free_slots.back();
+            free_slots.pop_back();
+        } else {
+            if (slots.size() >= MAX_SLOTS) return std::nullopt;
+
+            index = static_cast<uint32_t>(slots.size());
+            slots.emplace_back();
+        }
+
+        auto& target = slots[index];
+        target.client = std::move(client);
+        live.fetch_add(1, std::memory_order_relaxed);
+
+        return make_id(index, target.generation);
+    }
+
+    std::shared_ptr<connection> connection_registry::find(uint32_t id) const {
+        std::scoped_lock<std::mutex> lock(mtx);
+
+        uint32_t index = slot_index(id);
+        if (index >= slots.size()) return nullptr;
+
+        const auto& target = slots[index];
+        if (target.generation != slot_generation(id)) return nullptr;
+
+        return target.client;
+    }
+
+    bool connection_registry::erase(uint32_t id) {
+        std::shared_ptr<connection> removed;
+
+        {
+            std::scoped_lock<std::mutex> lock(mtx);
+
+            uint32_t index = slot_index(id);
+            if (index >= slots.size()) return false;
+
+            auto& target = slots[index];
+            if (!target.client || target.generation != slot_generation(id)) return false;
+
+            removed = std::move(target.client);
+
+            // generation 0 is skipped so an id is never 0
+            target.generation = (target.generation + 1) & GENERATION_MASK;
+            if (target.generation == 0) target.generation = 1;
+
+            free_slots.push_back(index);
+            live.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        // the connection is released outside of the lock, its destructor closes the socket
+        return true;
+    }
+
+    std::size_t connection_registry::live_count() const {
+        return live.load(std::memory_order_relaxed);
+    }
+
+    void connection_registry::for_each(const std::function<void(const std::shared_ptr<connection>&)>& fn) const {
+        std::scoped_lock<std::mutex> lock(mtx);
+
+        for (const auto& target : slots) {
+            if (target.client) fn(target.client);
+        }
+    }
+
+    std::vector<std::shared_ptr<connection>> connection_registry::snapshot() const {
+        std::vector<std::shared_ptr<connection>> out;
+        out.reserve(live_count());
+
+        for_each([&out](const std::shared_ptr<connection>& client){
+            out.push_back(client);
+        });
+
+        return out;
+    }
+
+    /*
+    --------------------------- PRIVATE MEMBER FUNCTIONS --------------------------------------
+    */
+    uint32_t connection_registry::slot_index(uint32_t id) {
+        return id & INDEX_MASK;
+    }
+
+    uint32_t connection_registry::slot_generation(uint32_t id) {
+        return (id >> INDEX_BITS) & GENERATION_MASK;
+    }
+
+    uint32_t connection_registry::make_id(uint32_t index, uint32_t generation) {
+        return ((generation & GENERATION_MASK) << INDEX_BITS) | (index & INDEX_MASK);
+    }
+}
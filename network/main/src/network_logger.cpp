@@ -0,0 +1,212 @@
+#include "network_logger.hpp"
+
+#include <cstdio>
+#include <ctime>
+
+namespace lynks::network {
+
+    /**
+     * @brief Per-thread state of the logger: the line stream used by the macros and the ring of the thread.
+     */
+    struct logger::thread_state {
+        line_buffer buffer;
+        std::ostream stream{&buffer};
+        std::shared_ptr<thread_ring> ring;
+
+        ~thread_state() {
+            if (ring) ring->retired.store(true, std::memory_order_release);
+        }
+    };
+
+    std::optional<log_level> parse_log_level(std::string_view name) {
+        if (name == "debug")    return log_level::debug;
+        if (name == "info")     return log_level::info;
+        if (name == "warning")  return log_level::warning;
+        if (name == "error")    return log_level::error;
+        if (name == "off")      return log_level::off;
+
+        return std::nullopt;
+    }
+
+    /*
+    --------------------------- CONSTRUCTORS --------------------------------------
+    */
+    logger::logger() {
+        flusher = std::thread([this](){ run(); });
+    }
+
+    logger::~logger() {
+        {
+            std::scoped_lock<std::mutex> lock(mtx);
+            stopping = true;
+        }
+
+        wake.notify_one();
+        if (flusher.joinable()) flusher.join();
+    }
+
+    /*
+    --------------------------- PUBLIC MEMBER FUNCTIONS --------------------------------------
+    */
+    logger& logger::instance() {
+        static logger log;
+        return log;
+    }
+
+    std::ostream& logger::begin_line() {
+        auto& state = local();
+        state.buffer.reset();
+        state.stream.clear();
+
+        return state.stream;
+    }
+
+    void logger::commit_line(log_level level, std::string_view tag) {
+        auto& state = local();
+        auto& ring = *state.ring;
+
+        std::size_t tail = ring.tail.load(std::memory_order_relaxed);
+        if (tail - ring.head.load(std::memory_order_acquire) >= RING_CAPACITY) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        record& line = ring.records[tail % RING_CAPACITY];
+        line.time = std::chrono::system_clock::now();
+        line.level = level;
+
+        line.tag_length = static_cast<uint8_t>(std::min(tag.size(), MAX_TAG));
+        std::copy_n(tag.data(), line.tag_length, line.tag);
+
+        auto text = state.buffer.view();
+        line.text_length = static_cast<uint16_t>(text.size());
+        std::copy_n(text.data(), text.size(), line.text);
+
+        ring.tail.store(tail + 1, std::memory_order_release);
+
+        // errors are written right away, everything else waits for the next flush interval
+        if (level >= log_level::error) wake.notify_one();
+    }
+
+    void logger::flush() {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (stopping) return;
+
+        // the drain running right now may have started before this call, wait for the one after it
+        uint64_t target = drain_generation + 2;
+        wake.notify_one();
+        drained.wait(lock, [this, target](){ return drain_generation >= target || stopping; });
+    }
+
+    /*
+    --------------------------- PRIVATE MEMBER FUNCTIONS --------------------------------------
+    */
+    logger::thread_state& logger::local() {
+        thread_local thread_state state;
+        if (!state.ring) state.ring = register_ring();
+
+        return state;
+    }
+
+    std::shared_ptr<logger::thread_ring> logger::register_ring() {
+        auto ring = std::make_shared<thread_ring>();
+
+        std::scoped_lock<std::mutex> lock(mtx);
+        rings.push_back(ring);
+
+        return ring;
+    }
+
+    bool logger::drain(std::string& out, std::string& err) {
+        std::vector<std::shared_ptr<thread_ring>> current;
+        {
+            std::scoped_lock<std::mutex> lock(mtx);
+
+            // rings of exited threads are dropped once they are empty
+            std::erase_if(rings, [](const std::shared_ptr<thread_ring>& ring){
+                return ring->retired.load(std::memory_order_acquire) &&
+                    ring->head.load(std::memory_order_relaxed) == ring->tail.load(std::memory_order_acquire);
+            });
+
+            current = rings;
+        }
+
+        for (auto& ring : current) {
+            std::size_t head = ring->head.load(std::memory_order_relaxed);
+            std::size_t tail = ring->tail.load(std::memory_order_acquire);
+
+            for (; head != tail; head++) {
+                const record& line = ring->records[head % RING_CAPACITY];
+                format(line, line.level >= log_level::warning ? err : out);
+            }
+
+            ring->head.store(head, std::memory_order_release);
+        }
+
+        return !out.empty() || !err.empty();
+    }
+
+    void logger::run() {
+        std::string out;
+        std::string err;
+
+        for (;;) {
+            bool stop;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                wake.wait_for(lock, FLUSH_INTERVAL);
+                stop = stopping;
+            }
+
+            out.clear();
+            err.clear();
+
+            if (drain(out, err)) {
+                if (!out.empty()) {
+                    std::fwrite(out.data(), 1, out.size(), stdout);
+                    std::fflush(stdout);
+                }
+
+                if (!err.empty()) {
+                    std::fwrite(err.data(), 1, err.size(), stderr);
+                    std::fflush(stderr);
+                }
+            }
+
+            {
+                std::scoped_lock<std::mutex> lock(mtx);
+                drain_generation++;
+            }
+            drained.notify_all();
+
+            if (stop) return;
+        }
+    }
+
+    /**
+     * @brief Appends `line` as `<UTC time> <LEVEL> [<tag>] <text>\n`.
+     */
+    void logger::format(const record& line, std::string& out) {
+        static constexpr std::string_view LEVELS[] = { "DEBUG", "INFO ", "WARN ", "ERROR", "OFF  " };
+
+        auto since_epoch = line.time.time_since_epoch();
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(since_epoch);
+        auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(since_epoch - seconds).count();
+
+        std::time_t time = static_cast<std::time_t>(seconds.count());
+        std::tm utc{};
+        gmtime_r(&time, &utc);
+
+        char stamp[32];
+        int stamp_length = std::snprintf(stamp, sizeof(stamp), "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ ",
+            utc.tm_year + 1900, utc.tm_mon + 1, utc.tm_mday, utc.tm_hour, utc.tm_min, utc.tm_sec, static_cast<int>(millis));
+
+        out.append(stamp, static_cast<std::size_t>(stamp_length));
+        out.append(LEVELS[static_cast<std::size_t>(line.level)]);
+        out.append(" [");
+        out.append(line.tag, line.tag_length);
+        out.append("] ");
+        out.append(line.text, line.text_length);
+        out.push_back('\n');
+    }
+}
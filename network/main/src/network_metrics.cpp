@@ -0,0 +1,144 @@
+#include "network_metrics.hpp"
+
+#include <cstdio>
+
+namespace lynks::network {
+
+    /*
+    --------------------------- LATENCY HISTOGRAM --------------------------------------
+    */
+    void latency_histogram::write(std::string& out, std::string_view name, std::string_view labels) const {
+        std::array<uint64_t, BUCKETS> merged{};
+        uint64_t sum_ns = 0;
+
+        for (const auto& target : shards) {
+            for (std::size_t i = 0; i < BUCKETS; i++) merged[i] += target.buckets[i].load(std::memory_order_relaxed);
+            sum_ns += target.sum_ns.load(std::memory_order_relaxed);
+        }
+
+        std::string bucket_name = std::string(name) + "_bucket";
+        std::string bucket_labels;
+
+        // every exported bound is the lower bound of a bucket, so the cumulative counts are exact
+        uint64_t below = 0;
+        for (std::size_t i = 0; i < BUCKETS; i++) {
+            uint64_t bound = lower_bound(i);
+
+            if (i > 0) {
+                char le[32];
+                std::snprintf(le, sizeof(le), "%.9g", static_cast<double>(bound) / 1e9);
+
+                bucket_labels.assign(labels);
+                if (!bucket_labels.empty()) bucket_labels += ",";
+                bucket_labels += "le=\"";
+                bucket_labels += le;
+                bucket_labels += "\"";
+
+                metrics_registry::write_sample(out, bucket_name, bucket_labels, below);
+            }
+
+            below += merged[i];
+        }
+
+        bucket_labels.assign(labels);
+        if (!bucket_labels.empty()) bucket_labels += ",";
+        bucket_labels += "le=\"+Inf\"";
+
+        metrics_registry::write_sample(out, bucket_name, bucket_labels, below);
+        metrics_registry::write_sample(out, std::string(name) + "_sum", labels, static_cast<double>(sum_ns) / 1e9);
+        metrics_registry::write_sample(out, std::string(name) + "_count", labels, below);
+    }
+
+    /*
+    --------------------------- METRICS SOURCE --------------------------------------
+    */
+    metrics_source& metrics_source::operator=(metrics_source&& other) noexcept {
+        if (this != &other) {
+            if (registry) registry->remove_source(id);
+
+            registry = std::exchange(other.registry, nullptr);
+            id = other.id;
+        }
+
+        return *this;
+    }
+
+    metrics_source::~metrics_source() {
+        if (registry) registry->remove_source(id);
+    }
+
+    /*
+    --------------------------- METRICS REGISTRY --------------------------------------
+    */
+    metrics_registry& metrics_registry::instance() {
+        static metrics_registry registry;
+        return registry;
+    }
+
+    metrics_source metrics_registry::add_source(writer write) {
+        std::scoped_lock<std::mutex> lock(mtx);
+
+        uint64_t id = next_id++;
+        sources.emplace_back(id, std::move(write));
+
+        return metrics_source(this, id);
+    }
+
+    std::string metrics_registry::render() const {
+        std::string out;
+        out.reserve(16 * 1024);
+
+        // sources are removed under the same lock, so none is destroyed while it is written
+        std::scoped_lock<std::mutex> lock(mtx);
+        for (const auto& [id, write] : sources) write(out);
+
+        return out;
+    }
+
+    void metrics_registry::write_type(std::string& out, std::string_view name, std::string_view type, std::string_view help) {
+        out += "# HELP ";
+        out += name;
+        out += " ";
+        out += help;
+        out += "\n# TYPE ";
+        out += name;
+        out += " ";
+        out += type;
+        out += "\n";
+    }
+
+    void metrics_registry::write_sample(std::string& out, std::string_view name, std::string_view labels, double value) {
+        char number[32];
+        std::snprintf(number, sizeof(number), "%.9g", value);
+
+        out += name;
+        if (!labels.empty()) {
+            out += "{";
+            out += labels;
+            out += "}";
+        }
+        out += " ";
+        out += number;
+        out += "\n";
+    }
+
+    void metrics_registry::write_sample(std::string& out, std::string_view name, std::string_view labels, uint64_t value) {
+        out += name;
+        if (!labels.empty()) {
+            out += "{";
+            out += labels;
+            out += "}";
+        }
+        out += " ";
+        out += std::to_string(value);
+        out += "\n";
+    }
+
+    void metrics_registry::remove_source(uint64_t id) {
+        std::scoped_lock<std::mutex> lock(mtx);
+
+        std::erase_if(sources, [id](const std::pair<uint64_t, writer>& source){
+            return source.first == id;
+        });
+    }
+}
@@ -1,7 +1,8 @@
 #include "network_mysql.hpp"
+#include "network_logger.hpp"
 
 namespace lynks::network {
-    mysql::pool_params db_connection::get_params() {
+    mysql::pool_params db_connection::get_params(std::size_t max_connections) {
         mysql::pool_params params;
         params.server_address.emplace_host_and_port(
             std::string(MYSQL_HOST),
@@ -11,6 +12,7 @@ namespace lynks::network {
         params.username = MYSQL_USERNAME;
         params.password = MYSQL_PASSWORD;
         params.thread_safe = true;
+        params.max_size = std::max<std::size_t>(max_connections, 1);
 
         return params;
     }
@@ -19,44 +21,61 @@ namespace lynks::network {
     --------------------------- CONSTRUCTORS --------------------------------------
     */
     
-    db_connection::db_connection(asio::io_context& context) 
-    : context(context), connection_pool(context, std::move(get_params()))
+    db_metrics::db_metrics()
+    : metrics(metrics_registry::instance().add_source([this](std::string& out){ write_metrics(out); })) {}
+
+    db_connection::db_connection(asio::io_context& context, db_metrics& stats, std::size_t max_connections) 
+    : context(context), connection_pool(context, std::move(get_params(max_connections))), stats(stats)
     {
         connection_pool.async_run(asio::detached);
     }
 
+    /* 
+    --------------------------- PUBLIC MEMBER FUNCTIONS --------------------------------------
+    */
+
+    void db_connection::shutdown() {
+        connection_pool.cancel();
+    }
+
     /* 
     --------------------------- PRIVATE MEMBER FUNCTIONS --------------------------------------
     */
 
     asio::awaitable<std::optional<mysql::results>> db_connection::send_query_impl(
+        request_deadline deadline,
         std::string_view sql,
         mysql::field_view const* params,
         std::size_t params_size
     ) {
         
         boost::system::error_code ec;
-        auto token = asio::cancel_after(
-            std::chrono::seconds(5),
-            asio::redirect_error(asio::use_awaitable, ec)
-        );
+
+        // every step gets its own limit, bounded by what is left of the deadline of the request
+        auto token = [&ec, deadline](){
+            return asio::cancel_at(step_deadline(deadline, STEP_TIMEOUT), asio::redirect_error(asio::use_awaitable, ec));
+        };
 
         // fetch a connection from the connection_pool
+        auto started = std::chrono::steady_clock::now();
         mysql::pooled_connection connection = co_await connection_pool.async_get_connection(
-            token
+            token()
         );
+        stats.acquire_latency.record(std::chrono::steady_clock::now() - started);
+
         if (ec) {
-            std::cerr << "[SERVER] Fetching connection failed: " << ec.message() << std::endl;
+            LYNKS_LOG_ERROR("MYSQL", "fetching connection failed: " << ec.message());
             co_return std::nullopt;
         }
 
         // prepare statement
+        started = std::chrono::steady_clock::now();
         mysql::statement statement = co_await connection->async_prepare_statement(
             sql,
-            token
+            token()
         );
         if (ec) {
-            std::cerr << "[SERVER] Preparing statement failed: " << ec.message() << std::endl;
+            LYNKS_LOG_ERROR("MYSQL", "preparing statement failed: " << ec.message());
             co_return std::nullopt;
         }
 
@@ -65,79 +84,97 @@ namespace lynks::network {
         co_await connection->async_execute(
             statement.bind(params, params + params_size),
             result,
-            token
+            token()
         );
+        stats.execute_latency.record(std::chrono::steady_clock::now() - started);
 
         if (ec) {
-            std::cerr << "[SERVER] Executing query failed: " << ec.message() << std::endl;
+            LYNKS_LOG_ERROR("MYSQL", "executing query failed: " << ec.message());
             co_return std::nullopt;
         }
 
-        std::cout << "[SERVER] Query Executed" << std::endl;
+        LYNKS_LOG_DEBUG("MYSQL", "query executed");
 
         co_return result;
     }
 
+    void db_metrics::write_metrics(std::string& out) const {
+        metrics_registry::write_type(out, "lynks_mysql_acquire_seconds", "histogram", "Time waiting for a connection from the MySQL pool.");
+        acquire_latency.write(out, "lynks_mysql_acquire_seconds", "");
+
+        metrics_registry::write_type(out, "lynks_mysql_execute_seconds", "histogram", "Time preparing and executing a MySQL statement.");
+        execute_latency.write(out, "lynks_mysql_execute_seconds", "");
+    }
+
     /**
      * @brief Static helper function for printing out field_views.
      */
-    static void print_field(const mysql::field_view& f){
+    static void print_field(std::ostream& os, const mysql::field_view& f){
     using mysql::field_kind;
 
     switch (f.kind()) {
         case field_kind::null:
-            std::cout << "NULL";
+            os << "NULL";
             break;
 
         case field_kind::int64:
-            std::cout << f.as_int64();
+            os << f.as_int64();
             break;
 
         case field_kind::uint64:
-            std::cout << f.as_uint64();
+            os << f.as_uint64();
             break;
 
         case field_kind::float_:
-            std::cout << f.as_float();
+            os << f.as_float();
             break;
 
         case field_kind::double_:
-            std::cout << f.as_double();
+            os << f.as_double();
             break;
 
         case field_kind::string:
-            std::cout << '"' << f.as_string() << '"';
+            os << '"' << f.as_string() << '"';
             break;
 
         case field_kind::blob:
-            std::cout << "<blob>(" << f.as_blob().size() << " bytes)";
+            os << "<blob>(" << f.as_blob().size() << " bytes)";
             break;
 
         case field_kind::date:
         case field_kind::datetime:
         case field_kind::time:
-            std::cout << f;
+            os << f;
             break;
 
         default:
-            std::cout << "<unknown>";
+            os << "<unknown>";
             break;
         }
     }
 
+    /**
+     * @brief Query parameters printed as ` [i] = value` when streamed.
+     */
+    struct printed_params {
+        mysql::field_view const* params;
+        std::size_t params_size;
+    };
+
+    static std::ostream& operator<<(std::ostream& os, const printed_params& printed) {
+        for (std::size_t i = 0; i < printed.params_size; ++i) {
+            os << " [" << i << "] = ";
+            print_field(os, printed.params[i]);
+        }
+
+        return os;
+    }
+
     void db_connection::debug_incoming_query(
-        std::string_view sql,
-        mysql::field_view const* params,
-        std::size_t params_size
+        [[maybe_unused]] std::string_view sql,
+        [[maybe_unused]] mysql::field_view const* params,
+        [[maybe_unused]] std::size_t params_size
     ) {
-        std::cout << "Incoming arguments:" << std::endl;
-        std::cout << "SQL: " << sql << std::endl;
-        std::cout << "Params (" << params_size << "):" << std::endl;
-        
-        for (std::size_t i = 0; i < params_size; ++i) {
-            std::cout << "  [" << i << "] = ";
-            print_field(params[i]);
-            std::cout << "" << std::endl;
-        }
+        LYNKS_LOG_DEBUG("MYSQL", "SQL: " << sql << " params (" << params_size << "):" << printed_params(params, params_size));
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,163 @@
+#include "network_response_cache.hpp"
+
+#include <sstream>
+
+namespace lynks::network {
+
+    /**
+     * @brief Static helper building the `503 Service Unavailable` reply.
+     */
+    static http_response make_service_unavailable(std::chrono::seconds retry_after) {
+        auto response = response_cache::make_text(http::status::service_unavailable, "503 service unavailable");
+        response.set(http::field::retry_after, std::to_string(retry_after.count()));
+
+        return response;
+    }
+
+    /**
+     * @brief Static helper building the `429 Too Many Requests` reply.
+     */
+    static http_response make_too_many_requests(std::chrono::seconds retry_after) {
+        auto response = response_cache::make_text(http::status::too_many_requests, "429 too many requests");
+        response.set(http::field::retry_after, std::to_string(retry_after.count()));
+
+        return response;
+    }
+
+    /**
+     * @brief Static helper building the head of the `200 OK` JSON responses.
+     */
+    static http_response make_json_head() {
+        auto response = response_cache::make_text(http::status::ok, "");
+        response.set(http::field::content_type, "application/json");
+
+        return response;
+    }
+
+    /*
+    --------------------------- CACHED REPLY --------------------------------------
+    */
+    cached_reply cached_reply::build(http_response response) {
+        cached_reply reply;
+
+        response.keep_alive(true);
+        response.set(http::field::connection, "keep-alive");
+        response.prepare_payload();
+        reply.keep_alive = response_cache::serialize(response);
+
+        response.keep_alive(false);
+        response.prepare_payload();
+        reply.close = response_cache::serialize(response);
+
+        return reply;
+    }
+
+    /*
+    --------------------------- RESPONSE TEMPLATE --------------------------------------
+    */
+    response_template response_template::build(http_response response) {
+        response_template result;
+
+        response.body().clear();
+        response.erase(http::field::content_length);
+
+        // the serialized header ends with the empty line, which is put back after the length
+        auto head = [&response](bool keep_alive){
+            response.keep_alive(keep_alive);
+            if (keep_alive) response.set(http::field::connection, "keep-alive");
+
+            std::ostringstream os;
+            os << response.base();
+
+            std::string head = os.str();
+            head.resize(head.size() - 2);
+            head += "Content-Length: ";
+
+            return head;
+        };
+
+        result.keep_alive_head = head(true);
+        result.close_head = head(false);
+
+        return result;
+    }
+
+    /*
+    --------------------------- CONSTRUCTORS --------------------------------------
+    */
+    response_cache::response_cache(std::chrono::seconds retry_after)
+    : unavailable(cached_reply::build(make_service_unavailable(retry_after))),
+      throttled(cached_reply::build(make_too_many_requests(retry_after))),
+      missing(cached_reply::build(make_text(http::status::not_found, "404 not found"))),
+      malformed(cached_reply::build(make_text(http::status::bad_request, "400 bad request"))),
+      too_large(cached_reply::build(make_text(http::status::payload_too_large, "413 payload too large"))),
+      unmet_expectation(cached_reply::build(make_text(http::status::expectation_failed, "417 expectation failed"))),
+      failed(cached_reply::build(make_text(http::status::internal_server_error, "500 internal server error"))),
+      timed_out(cached_reply::build(make_text(http::status::gateway_timeout, "504 gateway timeout"))),
+      healthy(cached_reply::build(make_text(http::status::ok, "ok"))),
+      json_ok(response_template::build(make_json_head()))
+    {}
+
+    /*
+    --------------------------- PUBLIC MEMBER FUNCTIONS --------------------------------------
+    */
+    const cached_reply& response_cache::service_unavailable() const {
+        return unavailable;
+    }
+
+    const cached_reply& response_cache::too_many_requests() const {
+        return throttled;
+    }
+
+    const cached_reply& response_cache::not_found() const {
+        return missing;
+    }
+
+    const cached_reply& response_cache::bad_request() const {
+        return malformed;
+    }
+
+    const cached_reply& response_cache::payload_too_large() const {
+        return too_large;
+    }
+
+    const cached_reply& response_cache::expectation_failed() const {
+        return unmet_expectation;
+    }
+
+    const cached_reply& response_cache::internal_error() const {
+        return failed;
+    }
+
+    const cached_reply& response_cache::gateway_timeout() const {
+        return timed_out;
+    }
+
+    const cached_reply& response_cache::health() const {
+        return healthy;
+    }
+
+    const response_template& response_cache::json() const {
+        return json_ok;
+    }
+
+    serialized_response response_cache::serialize(const http_response& response) {
+        std::ostringstream os;
+        os << response;
+        return std::make_shared<const std::string>(os.str());
+    }
+
+    http_response response_cache::make_text(http::status status, std::string body) {
+        // HTTP/1.0 clients are answered with HTTP/1.1 as well, the keep-alive variants name the
+        // `Connection` they keep explicitly, which is what a 1.0 client needs to reuse the connection
+        http_response response;
+        response.version(11);
+        response.result(status);
+        response.set(http::field::server, "My HTTP Server");
+        response.set(http::field::content_type, "text/plain");
+        response.body() = std::move(body);
+        response.prepare_payload();
+
+        return response;
+    }
+}
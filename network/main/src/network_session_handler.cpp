@@ -1,113 +1,99 @@
 #include "network_session_handler.hpp"
+#include "network_logger.hpp"
+
+#include <bit>
+#include <cstring>
 
 namespace lynks::network {
 
     /* 
     --------------------------- CONSTRUCTORS --------------------------------------
     */
-    session_handler::session_handler(uint16_t max_sessions)
-    : random_int64(0, -1), random_byte(0, 255), max_sessions(max_sessions) {
-        cleanup_thread = std::thread([this](){
-            cleanup_task();
-        });
-    }
+    session_handler::session_handler(std::size_t capacity)
+    : capacity(std::max<std::size_t>(capacity, 1)), random_int64(0, -1), random_byte(0, 255) {
+        auto stripe_count = std::bit_ceil(std::clamp<std::size_t>(this->capacity / STRIPE_SESSIONS, 1, MAX_STRIPES));
 
-    /* 
-    --------------------------- DESTRUCTORS --------------------------------------
-    */
-    session_handler::~session_handler() {
-        clean.store(false);
-        cv.notify_all();
+        // tokens are spread unevenly, every stripe may hold twice its share before it is full
+        auto stripe_capacity = std::min(this->capacity, 2 * (this->capacity / stripe_count + 1));
+
+        stripes.reserve(stripe_count);
+        for (std::size_t i = 0; i < stripe_count; i++) {
+            stripes.push_back(std::make_unique<session_table>(stripe_capacity));
+        }
 
-        if (cleanup_thread.joinable()) cleanup_thread.join();
+        metrics = metrics_registry::instance().add_source([this](std::string& out){ write_metrics(out); });
     }
 
     /* 
     --------------------------- PUBLIC MEMBER FUNCTIONS --------------------------------------
     */
-    std::optional<std::string> session_handler::new_session(std::string username) {
+    std::optional<std::string> session_handler::new_session(session_principal principal) {
+        std::string token;
         {
-            std::scoped_lock<std::mutex> lock(mtx);
+            std::scoped_lock<std::mutex> lock(random_mtx);
+            token = generate_token();
+        }
 
-            if (sessions.size() < max_sessions) {
-                auto token = session_token(username, generate_token());
-                auto token_str = token.get_token();
-                sessions.push_back(std::move(token));
+        auto key = parse_token(token);
+        if (!key) return std::nullopt;
 
-                return token_str;
+        // a full container first reclaims what expired since the last tick
+        for (int attempt = 0; attempt < 2; attempt++) {
+            if (held.fetch_add(1, std::memory_order_relaxed) < capacity) {
+                if (stripe_of(*key).insert(*key, principal)) return token;
             }
+
+            held.fetch_sub(1, std::memory_order_relaxed);
+            if (attempt == 0 && expire_sessions() == 0) break;
         }
 
-        std::cerr << "[SERVER] max_sessions hit" << std::endl;
-        clean_inactive_sessions();
+        LYNKS_LOG_WARNING("SESSION", "session capacity hit");
         return std::nullopt;
     }
 
     bool session_handler::validate_session(const std::string& token) {
-        std::scoped_lock<std::mutex> lock(mtx);
-        return is_active(token);
+        return with_session(token, [](session_token* session){
+            return session && session->validate_token();
+        });
     }
 
     std::optional<std::string> session_handler::get_username_by_token(const std::string& token) {
-        std::scoped_lock<std::mutex> lock(mtx);
+        return with_session(token, [](session_token* session) -> std::optional<std::string> {
+            if (session && session->is_active()) return session->get_principal().username;
+            return std::nullopt;
+        });
+    }
 
-        auto it = std::ranges::find_if(sessions, [&token](session_token& t){
-            return token == t.get_token();
+    std::optional<session_principal> session_handler::resolve(const std::string& token) {
+        return with_session(token, [](session_token* session) -> std::optional<session_principal> {
+            if (session && session->validate_token()) return session->get_principal();
+            return std::nullopt;
         });
+    }
 
-        if (it != sessions.end()) {
-            if (it->is_active()) return it->get_owner();
-        }
+    std::size_t session_handler::expire_sessions() {
+        auto now = session_token::get_now_ms();
 
-        return std::nullopt;
+        std::size_t removed = 0;
+        for (auto& stripe : stripes) removed += stripe->expire(now);
+
+        held.fetch_sub(removed, std::memory_order_relaxed);
+        return removed;
     }
 
-    void session_handler::clean_inactive_sessions() {
-        panic_clean.store(true);
-        cv.notify_one();
+    std::size_t session_handler::size() const {
+        return held.load(std::memory_order_relaxed);
     }
 
     /* 
     --------------------------- PRIVATE MEMBER FUNCTIONS --------------------------------------
     */
-    bool session_handler::is_active(const std::string& token) {
-        return find_token(token);
-    }
-
-    bool session_handler::find_token(const std::string& token) {
-        auto it = std::ranges::find_if(sessions, [&token](const session_token& t){
-            return token == t.get_token();
-        });
-
-        if (it != sessions.end()) {
-            return it->validate_token();
-        }
+    session_table& session_handler::stripe_of(const token_key& key) {
+        // bytes 8 to 15, the tables hash the first 8
+        uint64_t hash;
+        std::memcpy(&hash, key.data() + sizeof(hash), sizeof(hash));
 
-        return false;
-    }
-
-    void session_handler::cleanup_task() {
-        std::unique_lock<std::mutex> lock(mtx);
-
-        while(clean) {
-            cv.wait_for(
-                lock, 
-                std::chrono::milliseconds(CLEANUP_INTERVAL_MS),
-                [this]{
-                    return !clean || panic_clean;
-                }
-            );
-
-            if (!clean) break;
-            if (!sessions.empty()) {
-                auto it = std::ranges::remove_if(sessions, [](session_token& token){
-                    return !token.is_active();
-                });
-
-                sessions.erase(it.begin(), it.end());
-            }
-            if (panic_clean) panic_clean.store(false);
-        }
+        return *stripes[hash & (stripes.size() - 1)];
     }
 
     std::string session_handler::generate_token() {
@@ -136,4 +122,9 @@ namespace lynks::network {
 
         return temp;
     }
+
+    void session_handler::write_metrics(std::string& out) const {
+        metrics_registry::write_type(out, "lynks_sessions", "gauge", "Login sessions held, including ones that expired within the last second.");
+        metrics_registry::write_sample(out, "lynks_sessions", "", static_cast<uint64_t>(size()));
+    }
 }
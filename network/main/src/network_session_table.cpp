@@ -0,0 +1,202 @@
+#include "network_session_table.hpp"
+
+#include <bit>
+#include <cstring>
+
+namespace lynks::network {
+
+    /**
+     * @brief Value of every hex digit, `0xFF` for any other character.
+     */
+    static constexpr auto HEX_VALUES = [](){
+        std::array<uint8_t, 256> values{};
+        values.fill(0xFF);
+
+        for (int c = 0; c < 10; c++) values['0' + c] = static_cast<uint8_t>(c);
+        for (int c = 0; c < 6; c++) {
+            values['a' + c] = static_cast<uint8_t>(10 + c);
+            values['A' + c] = static_cast<uint8_t>(10 + c);
+        }
+
+        return values;
+    }();
+
+    std::optional<token_key> parse_token(std::string_view token) {
+        if (token.size() != 2 * std::tuple_size_v<token_key>) return std::nullopt;
+
+        token_key key;
+        uint8_t invalid = 0;
+
+        // validity is checked once at the end, the loop itself has no branches
+        for (std::size_t i = 0; i < key.size(); i++) {
+            uint8_t high = HEX_VALUES[static_cast<uint8_t>(token[2 * i])];
+            uint8_t low = HEX_VALUES[static_cast<uint8_t>(token[2 * i + 1])];
+
+            invalid |= (high | low) & 0xF0;
+            key[i] = static_cast<uint8_t>((high << 4) | low);
+        }
+
+        if (invalid) return std::nullopt;
+        return key;
+    }
+
+    /*
+    --------------------------- CONSTRUCTORS --------------------------------------
+    */
+    session_table::session_table(std::size_t capacity)
+    : current(new slot_array(std::bit_ceil(std::max<std::size_t>(capacity, 1) * 2))),
+      max_count(std::max<std::size_t>(capacity, 1)),
+      wheel(WHEEL_SLOTS),
+      current_tick(session_token::get_now_ms() / TICK_MS)
+    {}
+
+    /*
+    --------------------------- DESTRUCTORS --------------------------------------
+    */
+    session_table::~session_table() {
+        auto* table = current.load();
+
+        for (std::size_t i = 0; i <= table->mask; i++) {
+            auto* session = table->slots[i].load(std::memory_order_relaxed);
+            if (is_live(session)) delete session;
+        }
+
+        delete table;
+    }
+
+    /*
+    --------------------------- PUBLIC MEMBER FUNCTIONS --------------------------------------
+    */
+    bool session_table::insert(const token_key& key, session_principal principal) {
+        std::scoped_lock<std::mutex> lock(mtx);
+        if (count.load(std::memory_order_relaxed) >= max_count) return false;
+
+        // at least a quarter of the slots stays empty, which ends every probe sequence
+        auto* table = current.load(std::memory_order_relaxed);
+        if ((count.load(std::memory_order_relaxed) + tombstones + 1) * 4 > (table->mask + 1) * 3) {
+            rebuild();
+            table = current.load(std::memory_order_relaxed);
+        }
+
+        std::atomic<session_token*>* target = nullptr;
+        for (auto index = home_of(*table, key);; index = (index + 1) & table->mask) {
+            auto* session = table->slots[index].load(std::memory_order_relaxed);
+
+            if (!session) {
+                if (!target) target = &table->slots[index];
+                break;
+            }
+
+            if (session == tombstone()) {
+                if (!target) target = &table->slots[index];
+                continue;
+            }
+
+            if (session->get_key() == key) return false;
+        }
+
+        if (target->load(std::memory_order_relaxed) == tombstone()) tombstones--;
+
+        // published whole, readers see either the empty slot or the complete session
+        auto* session = new session_token(std::move(principal), key);
+        target->store(session, std::memory_order_release);
+        count.fetch_add(1, std::memory_order_relaxed);
+
+        schedule(session);
+        return true;
+    }
+
+    std::size_t session_table::expire(uint64_t now_ms) {
+        std::scoped_lock<std::mutex> lock(mtx);
+
+        auto now_tick = now_ms / TICK_MS;
+        if (now_tick < current_tick) return 0;
+
+        // after a stall one lap visits every bucket, the following calls catch up the rest
+        auto last_tick = std::min(now_tick, current_tick + WHEEL_SLOTS - 1);
+
+        std::vector<session_token*> removed;
+        for (; current_tick <= last_tick; current_tick++) {
+            auto due = std::move(wheel[current_tick & (WHEEL_SLOTS - 1)]);
+            wheel[current_tick & (WHEEL_SLOTS - 1)].clear();
+
+            for (auto* session : due) {
+                if (session->expires_at_ms() > now_ms) {
+                    schedule(session);
+                    continue;
+                }
+
+                unlink(session);
+                removed.push_back(session);
+            }
+        }
+
+        if (removed.empty()) return 0;
+
+        count.fetch_sub(removed.size(), std::memory_order_relaxed);
+
+        epoch.synchronize();
+        for (auto* session : removed) delete session;
+
+        return removed.size();
+    }
+
+    /*
+    --------------------------- PRIVATE MEMBER FUNCTIONS --------------------------------------
+    */
+    std::size_t session_table::home_of(const slot_array& table, const token_key& key) {
+        uint64_t hash;
+        std::memcpy(&hash, key.data(), sizeof(hash));
+
+        return static_cast<std::size_t>(hash) & table.mask;
+    }
+
+    session_token* session_table::find(const slot_array& table, const token_key& key) {
+        for (auto index = home_of(table, key);; index = (index + 1) & table.mask) {
+            auto* session = table.slots[index].load(std::memory_order_acquire);
+
+            if (!session) return nullptr;
+            if (session != tombstone() && session->get_key() == key) return session;
+        }
+    }
+
+    void session_table::rebuild() {
+        auto* old_table = current.load(std::memory_order_relaxed);
+        auto* new_table = new slot_array(old_table->mask + 1);
+
+        for (std::size_t i = 0; i <= old_table->mask; i++) {
+            auto* session = old_table->slots[i].load(std::memory_order_relaxed);
+            if (!is_live(session)) continue;
+
+            auto index = home_of(*new_table, session->get_key());
+            while (new_table->slots[index].load(std::memory_order_relaxed)) index = (index + 1) & new_table->mask;
+
+            new_table->slots[index].store(session, std::memory_order_relaxed);
+        }
+
+        current.store(new_table, std::memory_order_release);
+        tombstones = 0;
+
+        // readers still probing the old array keep it until they are done, the sessions move over
+        epoch.synchronize();
+        delete old_table;
+    }
+
+    void session_table::schedule(session_token* session) {
+        auto tick = std::max(session->expires_at_ms() / TICK_MS, current_tick + 1);
+        wheel[tick & (WHEEL_SLOTS - 1)].push_back(session);
+    }
+
+    void session_table::unlink(session_token* session) {
+        auto& table = *current.load(std::memory_order_relaxed);
+
+        for (auto index = home_of(table, session->get_key());; index = (index + 1) & table.mask) {
+            auto& slot = table.slots[index];
+            if (slot.load(std::memory_order_relaxed) != session) continue;
+
+            slot.store(tombstone(), std::memory_order_release);
+            tombstones++;
+            return;
+        }
+    }
+}
@@ -4,8 +4,8 @@ namespace lynks::network {
     /* 
     --------------------------- CONSTRUCTORS --------------------------------------
     */
-    session_token::session_token(std::string owner_identifier, std::string token)
-    : token(token), owner_identifier(owner_identifier), life_ms(get_now_ms())
+    session_token::session_token(session_principal principal, const token_key& key)
+    : key(key), principal(std::move(principal)), life_ms(get_now_ms())
     {}
 
     /* 
@@ -22,15 +22,23 @@ namespace lynks::network {
     }
 
     bool session_token::is_active() const {
-        return get_now_ms() - life_ms < max_life_ms;
+        // a refresh racing the clock read may be newer than `now`, which counts as active
+        auto now = get_now_ms();
+        auto last = life_ms.load(std::memory_order_relaxed);
+
+        return now < last || now - last < max_life_ms;
+    }
+
+    uint64_t session_token::expires_at_ms() const {
+        return life_ms.load(std::memory_order_relaxed) + max_life_ms;
     }
 
-    const std::string& session_token::get_owner() const {
-        return owner_identifier;
+    const session_principal& session_token::get_principal() const {
+        return principal;
     }
 
-    const std::string& session_token::get_token() const {
-        return token;
+    const token_key& session_token::get_key() const {
+        return key;
     }
 
     /* 
@@ -38,12 +46,12 @@ namespace lynks::network {
     */
 
     void session_token::update_life() {
-        life_ms = get_now_ms();
+        life_ms.store(get_now_ms(), std::memory_order_relaxed);
     }
 
-    uint64_t session_token::get_now_ms() const {
+    uint64_t session_token::get_now_ms() {
         return std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::system_clock::now().time_since_epoch()
+            std::chrono::steady_clock::now().time_since_epoch()
         ).count();
     }
 }
\ No newline at end of file
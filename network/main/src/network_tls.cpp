@@ -0,0 +1,79 @@
+#include "network_tls.hpp"
+
+namespace lynks::network {
+
+    /*
+    --------------------------- CONSTRUCTORS --------------------------------------
+    */
+    tls_context::tls_context(const tls_options& options)
+    : context(asio::ssl::context::tls_server),
+      metrics(metrics_registry::instance().add_source([this](std::string& out){ write_metrics(out); }))
+    {
+        context.set_options(
+            asio::ssl::context::default_workarounds |
+            asio::ssl::context::no_sslv2 |
+            asio::ssl::context::no_sslv3 |
+            asio::ssl::context::no_tlsv1 |
+            asio::ssl::context::no_tlsv1_1 |
+            asio::ssl::context::single_dh_use
+        );
+
+        context.use_certificate_chain_file(options.certificate_file);
+        context.use_private_key_file(options.private_key_file, asio::ssl::context::pem);
+
+        SSL_CTX* native = context.native_handle();
+
+        SSL_CTX_set_options(native, SSL_OP_CIPHER_SERVER_PREFERENCE | SSL_OP_NO_RENEGOTIATION);
+
+        // idle keep-alive connections give their read and write buffers back
+        SSL_CTX_set_mode(native, SSL_MODE_RELEASE_BUFFERS);
+
+        // sessions are resumed from the cache (session ids) or from tickets, tickets are on by default
+        SSL_CTX_set_session_cache_mode(native, SSL_SESS_CACHE_SERVER);
+        SSL_CTX_sess_set_cache_size(native, options.session_cache_size);
+        SSL_CTX_set_timeout(native, static_cast<long>(options.session_timeout.count()));
+        SSL_CTX_set_session_id_context(native, SESSION_ID_CONTEXT, sizeof(SESSION_ID_CONTEXT) - 1);
+
+        SSL_CTX_set_alpn_select_cb(native, &tls_context::select_protocol, nullptr);
+    }
+
+    /*
+    --------------------------- PUBLIC MEMBER FUNCTIONS --------------------------------------
+    */
+    void tls_context::handshake_done(SSL* ssl, std::chrono::steady_clock::duration elapsed) {
+        if (SSL_session_reused(ssl)) resumed_handshakes.add();
+        else full_handshakes.add();
+
+        handshake_latency.record(elapsed);
+    }
+
+    /*
+    --------------------------- PRIVATE MEMBER FUNCTIONS --------------------------------------
+    */
+
+    /**
+     * @brief ALPN callback. Picks `http/1.1` when the client offers it and continues without
+     * ALPN otherwise, so clients offering only `h2` fall back instead of failing the handshake.
+     */
+    int tls_context::select_protocol(SSL*, const unsigned char** out, unsigned char* out_length,
+        const unsigned char* in, unsigned int in_length, void*)
+    {
+        unsigned char* selected = nullptr;
+        int result = SSL_select_next_proto(&selected, out_length, ALPN_HTTP_1_1, sizeof(ALPN_HTTP_1_1), in, in_length);
+
+        if (result != OPENSSL_NPN_NEGOTIATED) return SSL_TLSEXT_ERR_NOACK;
+
+        *out = selected;
+        return SSL_TLSEXT_ERR_OK;
+    }
+
+    void tls_context::write_metrics(std::string& out) const {
+        metrics_registry::write_type(out, "lynks_tls_handshakes_total", "counter", "TLS handshakes, per result.");
+        metrics_registry::write_sample(out, "lynks_tls_handshakes_total", "result=\"full\"", full_handshakes.value());
+        metrics_registry::write_sample(out, "lynks_tls_handshakes_total", "result=\"resumed\"", resumed_handshakes.value());
+        metrics_registry::write_sample(out, "lynks_tls_handshakes_total", "result=\"failed\"", failed_handshakes.value());
+
+        metrics_registry::write_type(out, "lynks_tls_handshake_seconds", "histogram", "Time spent in successful TLS handshakes.");
+        handshake_latency.write(out, "lynks_tls_handshake_seconds", "");
+    }
+}
@@ -4,6 +4,7 @@
 
 #include "network_user.hpp"
 #include "network_crypto.hpp"
+#include "network_logger.hpp"
 
 #include "nlohmann/json.hpp"
 #include <regex>
@@ -27,10 +28,7 @@ namespace lynks::network {
             hash_password();
             validate_user();
         } catch (const std::exception& e) {
-            std::cerr << 
-                "[SERVER] unable to parse incoming json to object:" << std::endl <<
-                json_string << std::endl <<
-                "Error: " << e.what() << std::endl;
+            LYNKS_LOG_WARNING("USER", "unable to parse incoming json to object: " << e.what());
         }
     }
 
@@ -58,9 +56,7 @@ namespace lynks::network {
             json["users"]["password"] = password;
             return json.dump();
         } catch (const std::exception& e) {
-            std::cerr << 
-                "[SERVER] unable to parse object into json:\n" <<
-                to_string();
+            LYNKS_LOG_WARNING("USER", "unable to parse object into json: " << e.what());
         }
         
         return std::nullopt;